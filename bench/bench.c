@@ -0,0 +1,893 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include "include/cave-bedrock.h"
+#include "include/sieve.h"
+#include "include/parallel-sieve.h"
+#include "include/trial-division.h"
+#include "include/trial-kernel.h"
+#include "include/direct-filter.h"
+#include "include/prime-store.h"
+#include "include/prime-table.h"
+#include "include/prime-count.h"
+#include "include/growth-filter.h"
+#include "include/text-writer.h"
+#include "include/file-vec.h"
+#include "include/typed-vec.h"
+#include "include/allocator.h"
+#include "include/page-allocator.h"
+#include "include/parallel-vec.h"
+#include "include/hashmap.h"
+
+//Times the engines, and the vector operations they lean on, over a few sizes, and prints the stats as JSON so
+//runs before and after a change can be compared by a script rather than by eye. Run with --help for the options.
+//
+//Each benchmark is run `warmup` times untimed, then `repetitions` times timed, each time on fresh inputs, and
+//the times are reported as min, median, 90th and 99th percentile, max and mean, in nanoseconds, along with how
+//many items a second the median works out to. What an item is depends on the benchmark: a number below the
+//bound for the engines, an element for the vector operations.
+
+#define MAX_SIZES (16)
+#define DEFAULT_WARMUP (2)
+#define DEFAULT_REPETITIONS (11)
+
+//everything a benchmark works on. Set up before each repetition, outside the timing.
+typedef struct BenchState {
+    CaveVec input;
+    CaveVec output;
+    CaveFileVec file_vec;
+    U64Vec typed;
+    CaveArena arena;
+    CavePool pool;
+    CavePageAllocator pages;
+    CaveHashMap map;
+    PrimeStore store;
+    PrimeTable table;
+    char table_path[4096];
+    BasePrimes base;
+    FILE* null_stream;
+    //results are added in here, so the compiler can't skip the work that makes them.
+    uint64_t sink;
+} BenchState;
+
+typedef struct Benchmark {
+    char const* name;
+    //called before every repetition, untimed. May be NULL.
+    void (*setup)(BenchState* s, uint64_t size, CaveError* err);
+    //the part that's timed.
+    void (*run)(BenchState* s, uint64_t size, CaveError* err);
+    //called after every repetition, untimed. May be NULL.
+    void (*teardown)(BenchState* s);
+    //the sizes are capped at this, since some benchmarks are far slower than others. 0 for no cap.
+    uint64_t max_size;
+} Benchmark;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+//the engines
+
+static void count_batch(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    (void)primes;
+    *(uint64_t*)closure_data += count;
+    *err = CAVE_NO_ERROR;
+}
+
+static void run_sieve(BenchState* s, uint64_t size, CaveError* err) {
+    sieve_foreach_batch(size, 0, WHEEL_210, count_batch, &s->sink, err);
+}
+
+static void run_parallel_sieve(BenchState* s, uint64_t size, CaveError* err) {
+    parallel_sieve_foreach_batch(size, 0, WHEEL_210, 0, count_batch, &s->sink, err);
+}
+
+static void run_trial_division(BenchState* s, uint64_t size, CaveError* err) {
+    trial_division_foreach_batch(size, WHEEL_210, count_batch, &s->sink, err);
+}
+
+static void run_direct_filter(BenchState* s, uint64_t size, CaveError* err) {
+    CaveVec filtered;
+    if(cave_vec_init(&filtered, sizeof(uint64_t), 0, err) == NULL) {
+        return;
+    }
+    direct_filtered_primes_below(&filtered, size, GROWTH_FILTER_DEFAULT_FACTOR, err);
+    s->sink += filtered.len;
+    cave_vec_release(&filtered);
+}
+
+static void run_prime_count(BenchState* s, uint64_t size, CaveError* err) {
+    s->sink += prime_count_below(size, err);
+}
+
+//check_if_prime() on `size` odd numbers from 2^32 on, against a base table that's already made.
+
+#define CHECK_IF_PRIME_FIRST (((uint64_t)1 << 32) + 1)
+
+static void setup_check_if_prime(BenchState* s, uint64_t size, CaveError* err) {
+    if(base_primes_init(&s->base, CHECK_IF_PRIME_FIRST + 2 * size, err) != NULL
+       && base_primes_init_divisors(&s->base, err) == NULL) {
+        base_primes_release(&s->base);
+    }
+}
+
+static void run_check_if_prime(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t found = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        found += check_if_prime(CHECK_IF_PRIME_FIRST + 2 * i, &s->base, 0);
+    }
+    s->sink += found;
+    *err = CAVE_NO_ERROR;
+}
+
+static void teardown_check_if_prime(BenchState* s) {
+    base_primes_release(&s->base);
+}
+
+//the vector operations, on `size` uint64_t's.
+
+static void setup_empty(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    cave_vec_init(&s->input, sizeof(uint64_t), 0, err);
+}
+
+static void setup_filled(BenchState* s, uint64_t size, CaveError* err) {
+    if(cave_vec_init(&s->input, sizeof(uint64_t), size > 0 ? size : 1, err) == NULL) {
+        return;
+    }
+    //roughly prime-shaped values, so the filter keeps some and drops some.
+    for(uint64_t i = 0; i < size && *err == CAVE_NO_ERROR; i++) {
+        uint64_t value = i * 2 + 1;
+        cave_vec_push(&s->input, &value, err);
+    }
+}
+
+static void teardown_input(BenchState* s) {
+    cave_vec_release(&s->input);
+}
+
+static void teardown_input_output(BenchState* s) {
+    cave_vec_release(&s->input);
+    cave_vec_release(&s->output);
+}
+
+static void run_cave_vec_push(BenchState* s, uint64_t size, CaveError* err) {
+    for(uint64_t i = 0; i < size; i++) {
+        if(cave_vec_push(&s->input, &i, err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->input.len;
+}
+
+//the same values as run_cave_vec_push(), a batch at a time, as the engines hand them out.
+static void run_cave_vec_push_n(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t batch[4096];
+    for(uint64_t i = 0; i < size; i += 4096) {
+        size_t n = size - i < 4096 ? (size_t)(size - i) : 4096;
+        for(size_t j = 0; j < n; j++) {
+            batch[j] = i + j;
+        }
+        if(cave_vec_push_n(&s->input, batch, n, err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->input.len;
+}
+
+//the file goes wherever TMPDIR says, since /tmp is often in memory, which would defeat the point.
+static void setup_file_vec(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    char const* dir = getenv("TMPDIR");
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/filtered-primes-bench.vec", dir != NULL ? dir : "/tmp");
+    cave_file_vec_init(&s->file_vec, path, sizeof(uint64_t), 0, err);
+    //the file only needs to last as long as the mapping.
+    unlink(path);
+}
+
+static void teardown_file_vec(BenchState* s) {
+    CaveError err;
+    cave_file_vec_release(&s->file_vec, &err);
+}
+
+static void run_cave_file_vec_push(BenchState* s, uint64_t size, CaveError* err) {
+    for(uint64_t i = 0; i < size; i++) {
+        if(cave_file_vec_push(&s->file_vec, &i, err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->file_vec.vec.len;
+}
+
+static void run_cave_vec_at_unchecked(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        sum += *(uint64_t*)cave_vec_at_unchecked(&s->input, i);
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+//the compact prime store, on `size` ascending values spaced like primes: mostly small even gaps, each a byte
+//apiece, and every so often one too big for a byte.
+
+static void setup_store_input(BenchState* s, uint64_t size, CaveError* err) {
+    if(cave_vec_init(&s->input, sizeof(uint64_t), size > 0 ? size : 1, err) == NULL) {
+        return;
+    }
+    uint64_t value = 2;
+    uint64_t x = 1;
+    for(uint64_t i = 0; i < size && *err == CAVE_NO_ERROR; i++) {
+        cave_vec_push(&s->input, &value, err);
+        x = x * 6364136223846793005u + 1442695040888963407u;
+        value += x >> 60 == 0 ? 1000 + 2 * (x % 64) : 2 + 2 * ((x >> 32) % 40);
+    }
+    if(*err == CAVE_NO_ERROR && prime_store_init(&s->store, err) == NULL) {
+        cave_vec_release(&s->input);
+    }
+}
+
+static void setup_store_filled(BenchState* s, uint64_t size, CaveError* err) {
+    setup_store_input(s, size, err);
+    if(*err == CAVE_NO_ERROR) {
+        prime_store_push_n(&s->store, s->input.data, s->input.len, err);
+    }
+}
+
+static void teardown_store(BenchState* s) {
+    cave_vec_release(&s->input);
+    prime_store_release(&s->store);
+}
+
+static void run_prime_store_push(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t const* values = s->input.data;
+    for(uint64_t i = 0; i < size; i++) {
+        if(prime_store_push(&s->store, values[i], err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->store.len;
+}
+
+static void run_prime_store_iter(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    PrimeStoreIter it;
+    prime_store_iter_init(&it, &s->store, 0);
+    uint64_t prime;
+    uint64_t sum = 0;
+    while(prime_store_iter_next(&it, &prime)) {
+        sum += prime;
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+//`size` lookups at random indices, each decoding up to a block's worth of gaps.
+static void run_prime_store_at(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t len = s->store.len;
+    uint64_t x = 1;
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        x = x * 6364136223846793005u + 1442695040888963407u;
+        sum += prime_store_at(&s->store, (size_t)(((unsigned __int128)x * len) >> 64), err);
+    }
+    s->sink += sum;
+}
+
+//opening a table file of `size` values, which maps it rather than reading it, so without verifying it should
+//take the same time at every size. Verifying reads every value, which is the time parsing would at least take.
+
+static void setup_table(BenchState* s, uint64_t size, CaveError* err) {
+    char const* dir = getenv("TMPDIR");
+    snprintf(s->table_path, sizeof(s->table_path), "%s/filtered-primes-bench.bin", dir != NULL ? dir : "/tmp");
+    PrimeTableWriter w;
+    if(prime_table_writer_open(&w, s->table_path, size * 2 + 2, 0, prime_table_width_for(size * 2 + 2), err)
+       == NULL) {
+        return;
+    }
+    uint64_t batch[4096];
+    for(uint64_t i = 0; i < size && *err == CAVE_NO_ERROR; i += 4096) {
+        size_t n = size - i < 4096 ? (size_t)(size - i) : 4096;
+        for(size_t j = 0; j < n; j++) {
+            batch[j] = (i + j) * 2 + 1;
+        }
+        prime_table_writer_write(&w, batch, n, err);
+    }
+    if(*err != CAVE_NO_ERROR) {
+        prime_table_writer_abandon(&w);
+        return;
+    }
+    prime_table_writer_close(&w, err);
+}
+
+static void teardown_table(BenchState* s) {
+    remove(s->table_path);
+}
+
+static void run_prime_table_open(BenchState* s, uint64_t size, bool verify, CaveError* err) {
+    if(prime_table_open(&s->table, s->table_path, verify, err) == NULL) {
+        return;
+    }
+    //the first and last values, as a lookup right after opening would.
+    if(size > 0) {
+        s->sink += prime_table_at(&s->table, 0) + prime_table_at(&s->table, size - 1);
+    }
+    prime_table_close(&s->table);
+}
+
+static void run_prime_table_open_mapped(BenchState* s, uint64_t size, CaveError* err) {
+    run_prime_table_open(s, size, false, err);
+}
+
+static void run_prime_table_open_verified(BenchState* s, uint64_t size, CaveError* err) {
+    run_prime_table_open(s, size, true, err);
+}
+
+//the typed vector, for comparing against CaveVec.
+
+static void setup_typed_empty(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    u64_vec_init(&s->typed, 0, err);
+}
+
+static void setup_typed_filled(BenchState* s, uint64_t size, CaveError* err) {
+    if(u64_vec_init(&s->typed, size > 0 ? size : 1, err) == NULL) {
+        return;
+    }
+    for(uint64_t i = 0; i < size; i++) {
+        u64_vec_push(&s->typed, i * 2 + 1, err);
+    }
+}
+
+static void teardown_typed(BenchState* s) {
+    u64_vec_release(&s->typed);
+}
+
+//an arena with room for the vector's last growth, so every time it grows, it grows in place.
+static void setup_typed_arena(BenchState* s, uint64_t size, CaveError* err) {
+    size_t capacity = CAVE_VEC_DEFAULT_CAPACITY;
+    while(capacity < size) {
+        capacity *= CAVE_VEC_GROW_FACTOR;
+    }
+    if(cave_arena_init(&s->arena, capacity * sizeof(uint64_t), err) == NULL) {
+        return;
+    }
+    if(u64_vec_init_with_allocator(&s->typed, cave_arena_allocator(&s->arena), 0, err) == NULL) {
+        cave_arena_release(&s->arena);
+    }
+}
+
+static void teardown_typed_arena(BenchState* s) {
+    u64_vec_release(&s->typed);
+    cave_arena_release(&s->arena);
+}
+
+//a pool with one block, big enough for the vector's last growth, so every time it grows, it grows in place, as on
+//the arena.
+static void setup_typed_pool(BenchState* s, uint64_t size, CaveError* err) {
+    size_t capacity = CAVE_VEC_DEFAULT_CAPACITY;
+    while(capacity < size) {
+        capacity *= CAVE_VEC_GROW_FACTOR;
+    }
+    if(cave_pool_init(&s->pool, capacity * sizeof(uint64_t), 1, err) == NULL) {
+        return;
+    }
+    if(u64_vec_init_with_allocator(&s->typed, cave_pool_allocator(&s->pool), 0, err) == NULL) {
+        cave_pool_release(&s->pool);
+    }
+}
+
+static void teardown_typed_pool(BenchState* s) {
+    u64_vec_release(&s->typed);
+    cave_pool_release(&s->pool);
+}
+
+static void run_u64_vec_push(BenchState* s, uint64_t size, CaveError* err) {
+    for(uint64_t i = 0; i < size; i++) {
+        if(u64_vec_push(&s->typed, i, err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->typed.len;
+}
+
+//the same loop as run_cave_vec_at_unchecked(), which the compiler can vectorize now it can see the stride.
+static void run_u64_vec_sum(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t const* data = s->typed.data;
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        sum += data[i];
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+//the typed vector on pages from a CavePageAllocator. The vector starts with room for every element, so the
+//pushes are timed without any growing, and what's left is the cost of faulting the pages in as they're first
+//written (unless they were prefaulted, in the untimed setup).
+
+static void setup_pages(BenchState* s, uint64_t size, CaveHugePages huge_pages, bool prefault, bool fill,
+                        CaveError* err) {
+    cave_page_allocator_init(&s->pages, huge_pages, prefault, err);
+    if(u64_vec_init_with_allocator(&s->typed, cave_page_allocator(&s->pages), size > 0 ? size : 1, err) == NULL) {
+        return;
+    }
+    for(uint64_t i = 0; fill && i < size; i++) {
+        u64_vec_push(&s->typed, i * 2 + 1, err);
+    }
+}
+
+static void setup_pages_4k(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_NONE, false, false, err);
+}
+
+static void setup_pages_4k_prefault(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_NONE, true, false, err);
+}
+
+static void setup_pages_thp(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_TRANSPARENT, false, false, err);
+}
+
+static void setup_pages_thp_prefault(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_TRANSPARENT, true, false, err);
+}
+
+static void setup_pages_hugetlb(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_EXPLICIT, false, false, err);
+}
+
+static void setup_pages_4k_filled(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_NONE, false, true, err);
+}
+
+static void setup_pages_thp_filled(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_TRANSPARENT, false, true, err);
+}
+
+static void setup_pages_hugetlb_filled(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages(s, size, CAVE_HUGE_PAGES_EXPLICIT, false, true, err);
+}
+
+//starting from the default capacity instead, so the vector grows, by mremap, as it goes. Compare with
+//u64_vec_push, which grows by realloc.
+static void setup_pages_growing(BenchState* s, uint64_t size, double growth_factor, CaveError* err) {
+    (void)size;
+    cave_page_allocator_init(&s->pages, CAVE_HUGE_PAGES_NONE, false, err);
+    if(u64_vec_init_with_allocator(&s->typed, cave_page_allocator(&s->pages), 0, err) != NULL) {
+        u64_vec_set_growth_factor(&s->typed, growth_factor, err);
+    }
+}
+
+static void setup_pages_grow_2(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages_growing(s, size, 2, err);
+}
+
+static void setup_pages_grow_1_25(BenchState* s, uint64_t size, CaveError* err) {
+    setup_pages_growing(s, size, 1.25, err);
+}
+
+//reads `size` elements from all over the vector, so nearly every read is to a different page than the last,
+//which is where the TLB misses come from.
+static void run_u64_vec_random_read(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t const* data = s->typed.data;
+    uint64_t len = s->typed.len;
+    uint64_t x = 1;
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        x = x * 6364136223846793005u + 1442695040888963407u;
+        sum += data[(uint64_t)(((unsigned __int128)x * len) >> 64)];
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+//clearing hands the pages back, so filling the vector again has to fault them all in again.
+static void run_u64_vec_clear_refill(BenchState* s, uint64_t size, CaveError* err) {
+    u64_vec_clear(&s->typed);
+    run_u64_vec_push(s, size, err);
+}
+
+static bool keep_if_not_multiple_of_3(void const* element, void* closure_data, CaveError* err) {
+    (void)closure_data;
+    (void)err;
+    return *(uint64_t const*)element % 3 != 0;
+}
+
+static void run_cave_vec_filter(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    if(cave_vec_filter(&s->input, keep_if_not_multiple_of_3, NULL, err) != NULL) {
+        s->sink += s->input.len;
+    }
+}
+
+static void double_it(void const* input_elm, void* output_elm, void* closure_data, CaveError* err) {
+    (void)closure_data;
+    (void)err;
+    *(uint64_t*)output_elm = *(uint64_t const*)input_elm * 2;
+}
+
+static void halve_it(void* element, void* closure_data, CaveError* err) {
+    (void)closure_data;
+    (void)err;
+    *(uint64_t*)element /= 2;
+}
+
+static void run_cave_vec_foreach(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    if(cave_vec_foreach(&s->input, halve_it, NULL, err) != NULL) {
+        s->sink += *(uint64_t*)s->input.data;
+    }
+}
+
+static void run_cave_vec_map(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    //cave_vec_map() initializes output, so teardown releases it. If it fails it may not have, so it's made
+    //valid for the teardown.
+    if(cave_vec_map(&s->output, &s->input, sizeof(uint64_t), double_it, NULL, err) == NULL) {
+        CaveError init_err;
+        cave_vec_init(&s->output, sizeof(uint64_t), 0, &init_err);
+        return;
+    }
+    s->sink += s->output.len;
+}
+
+//the parallel versions of the three above, on one thread per processor.
+
+static void run_cave_vec_parallel_filter(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    if(cave_vec_parallel_filter(&s->input, 0, keep_if_not_multiple_of_3, NULL, err) != NULL) {
+        s->sink += s->input.len;
+    }
+}
+
+static void run_cave_vec_parallel_map(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    //left uninitialized if it fails, like cave_vec_map().
+    if(cave_vec_parallel_map(&s->output, &s->input, sizeof(uint64_t), 0, double_it, NULL, err) == NULL) {
+        CaveError init_err;
+        cave_vec_init(&s->output, sizeof(uint64_t), 0, &init_err);
+        return;
+    }
+    s->sink += s->output.len;
+}
+
+static void run_cave_vec_parallel_foreach(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    if(cave_vec_parallel_foreach(&s->input, 0, halve_it, NULL, err) != NULL) {
+        s->sink += *(uint64_t*)s->input.data;
+    }
+}
+
+//the hashmap, from uint64_t to uint64_t.
+
+static void setup_hashmap_empty(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    cave_hashmap_init(&s->map, sizeof(uint64_t), sizeof(uint64_t), 0, NULL, NULL, NULL, err);
+}
+
+static void setup_hashmap_filled(BenchState* s, uint64_t size, CaveError* err) {
+    if(cave_hashmap_init(&s->map, sizeof(uint64_t), sizeof(uint64_t), size, NULL, NULL, NULL, err) == NULL) {
+        return;
+    }
+    for(uint64_t i = 0; i < size && *err == CAVE_NO_ERROR; i++) {
+        cave_hashmap_insert(&s->map, &i, &i, err);
+    }
+}
+
+static void teardown_hashmap(BenchState* s) {
+    cave_hashmap_release(&s->map);
+}
+
+static void run_cave_hashmap_insert(BenchState* s, uint64_t size, CaveError* err) {
+    for(uint64_t i = 0; i < size; i++) {
+        if(cave_hashmap_insert(&s->map, &i, &i, err) == NULL) {
+            return;
+        }
+    }
+    s->sink += s->map.len;
+}
+
+//every key looked up is in the map.
+static void run_cave_hashmap_get(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        uint64_t const* value = cave_hashmap_get(&s->map, &i, err);
+        if(value == NULL) {
+            return;
+        }
+        sum += *value;
+    }
+    s->sink += sum;
+}
+
+//none of them are.
+static void run_cave_hashmap_get_miss(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t found = 0;
+    for(uint64_t i = size; i < 2 * size; i++) {
+        found += cave_hashmap_get(&s->map, &i, err) != NULL;
+    }
+    s->sink += found;
+    *err = CAVE_NO_ERROR;
+}
+
+//reducing `size` hashes modulo a prime only known at runtime, by dividing and with cave_fastmod(), which is
+//the step that picks a hashmap slot.
+static volatile uint64_t reduce_divisor = 6420734989;
+
+static void run_reduce_divide(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t d = reduce_divisor;
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        sum += (i * UINT64_C(0x9e3779b97f4a7c15)) % d;
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+static void run_reduce_fastmod(BenchState* s, uint64_t size, CaveError* err) {
+    uint64_t d = reduce_divisor;
+    unsigned __int128 m = cave_fastmod_constant(d);
+    uint64_t sum = 0;
+    for(uint64_t i = 0; i < size; i++) {
+        sum += cave_fastmod(i * UINT64_C(0x9e3779b97f4a7c15), m, d);
+    }
+    s->sink += sum;
+    *err = CAVE_NO_ERROR;
+}
+
+static void run_fprint_vec_of_uint64(BenchState* s, uint64_t size, CaveError* err) {
+    (void)size;
+    fprint_vec_of_uint64(&s->input, s->null_stream, err);
+}
+
+static Benchmark const BENCHMARKS[] = {
+        {"check_if_prime", setup_check_if_prime, run_check_if_prime, teardown_check_if_prime, 0},
+        {"engine/sieve", NULL, run_sieve, NULL, 0},
+        {"engine/parallel", NULL, run_parallel_sieve, NULL, 0},
+        //trial division slows down with the bound far faster than the sieve does.
+        {"engine/trial", NULL, run_trial_division, NULL, 100000000},
+        {"engine/direct", NULL, run_direct_filter, NULL, 0},
+        {"engine/count", NULL, run_prime_count, NULL, 0},
+        {"cave_vec_push", setup_empty, run_cave_vec_push, teardown_input, 0},
+        {"cave_vec_push_n", setup_empty, run_cave_vec_push_n, teardown_input, 0},
+        {"cave_file_vec_push", setup_file_vec, run_cave_file_vec_push, teardown_file_vec, 0},
+        {"cave_vec_at_unchecked", setup_filled, run_cave_vec_at_unchecked, teardown_input, 0},
+        {"prime_store_push", setup_store_input, run_prime_store_push, teardown_store, 0},
+        {"prime_store_iter", setup_store_filled, run_prime_store_iter, teardown_store, 0},
+        //each lookup decodes around half a block, so it's far slower per item than walking the store.
+        {"prime_store_at", setup_store_filled, run_prime_store_at, teardown_store, 1000000},
+        {"prime_table_open", setup_table, run_prime_table_open_mapped, teardown_table, 0},
+        {"prime_table_open/verify", setup_table, run_prime_table_open_verified, teardown_table, 0},
+        {"u64_vec_push", setup_typed_empty, run_u64_vec_push, teardown_typed, 0},
+        {"u64_vec_push/arena", setup_typed_arena, run_u64_vec_push, teardown_typed_arena, 0},
+        {"u64_vec_push/pool", setup_typed_pool, run_u64_vec_push, teardown_typed_pool, 0},
+        {"u64_vec_sum", setup_typed_filled, run_u64_vec_sum, teardown_typed, 0},
+        {"page_vec_push/4k", setup_pages_4k, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_push/4k-prefault", setup_pages_4k_prefault, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_push/thp", setup_pages_thp, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_push/thp-prefault", setup_pages_thp_prefault, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_push/hugetlb", setup_pages_hugetlb, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_grow/2", setup_pages_grow_2, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_grow/1.25", setup_pages_grow_1_25, run_u64_vec_push, teardown_typed, 0},
+        {"page_vec_random_read/4k", setup_pages_4k_filled, run_u64_vec_random_read, teardown_typed, 0},
+        {"page_vec_random_read/thp", setup_pages_thp_filled, run_u64_vec_random_read, teardown_typed, 0},
+        {"page_vec_random_read/hugetlb", setup_pages_hugetlb_filled, run_u64_vec_random_read, teardown_typed, 0},
+        {"page_vec_clear_refill/4k", setup_pages_4k_filled, run_u64_vec_clear_refill, teardown_typed, 0},
+        {"page_vec_clear_refill/thp", setup_pages_thp_filled, run_u64_vec_clear_refill, teardown_typed, 0},
+        {"cave_vec_filter", setup_filled, run_cave_vec_filter, teardown_input, 0},
+        {"cave_vec_map", setup_filled, run_cave_vec_map, teardown_input_output, 0},
+        {"cave_vec_foreach", setup_filled, run_cave_vec_foreach, teardown_input, 0},
+        {"cave_vec_parallel_filter", setup_filled, run_cave_vec_parallel_filter, teardown_input, 0},
+        {"cave_vec_parallel_map", setup_filled, run_cave_vec_parallel_map, teardown_input_output, 0},
+        {"cave_vec_parallel_foreach", setup_filled, run_cave_vec_parallel_foreach, teardown_input, 0},
+        {"cave_hashmap_insert", setup_hashmap_empty, run_cave_hashmap_insert, teardown_hashmap, 0},
+        {"cave_hashmap_get", setup_hashmap_filled, run_cave_hashmap_get, teardown_hashmap, 0},
+        {"cave_hashmap_get/miss", setup_hashmap_filled, run_cave_hashmap_get_miss, teardown_hashmap, 0},
+        {"reduce/divide", NULL, run_reduce_divide, NULL, 0},
+        {"reduce/fastmod", NULL, run_reduce_fastmod, NULL, 0},
+        {"fprint_vec_of_uint64", setup_filled, run_fprint_vec_of_uint64, teardown_input, 0},
+};
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static int compare_uint64(void const* a, void const* b) {
+    uint64_t x = *(uint64_t const*)a;
+    uint64_t y = *(uint64_t const*)b;
+    return (x > y) - (x < y);
+}
+
+//the nearest-rank percentile of sorted, which has count entries.
+static uint64_t percentile(uint64_t const* sorted, size_t count, unsigned p) {
+    size_t rank = (count * p + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+//runs b at size, and prints its stats as a JSON object. times has room for warmup + repetitions.
+static bool run_benchmark(Benchmark const* b, uint64_t size, unsigned warmup, unsigned repetitions,
+                          BenchState* s, uint64_t* times, FILE* out, bool first) {
+    CaveError err = CAVE_NO_ERROR;
+    for(unsigned i = 0; i < warmup + repetitions; i++) {
+        if(b->setup != NULL) {
+            b->setup(s, size, &err);
+            if(err != CAVE_NO_ERROR) {
+                break;
+            }
+        }
+        uint64_t start = now_ns();
+        b->run(s, size, &err);
+        uint64_t end = now_ns();
+        if(b->teardown != NULL) {
+            b->teardown(s);
+        }
+        if(err != CAVE_NO_ERROR) {
+            break;
+        }
+        if(i >= warmup) {
+            times[i - warmup] = end - start;
+        }
+    }
+    if(err != CAVE_NO_ERROR) {
+        fprintf(stderr, "Error: %s at size %" PRIu64 ": %s\n", b->name, size, cave_error_string(err));
+        return false;
+    }
+
+    qsort(times, repetitions, sizeof(uint64_t), compare_uint64);
+    uint64_t total = 0;
+    for(unsigned i = 0; i < repetitions; i++) {
+        total += times[i];
+    }
+    uint64_t median = percentile(times, repetitions, 50);
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"size\": %" PRIu64 ", \"repetitions\": %u, "
+                 "\"min_ns\": %" PRIu64 ", \"median_ns\": %" PRIu64 ", \"p90_ns\": %" PRIu64 ", "
+                 "\"p99_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64 ", \"mean_ns\": %.1f, "
+                 "\"items_per_second\": %.6g}",
+            first ? "" : ",", b->name, size, repetitions,
+            times[0], median, percentile(times, repetitions, 90), percentile(times, repetitions, 99),
+            times[repetitions - 1], (double)total / repetitions,
+            median > 0 ? (double)size * 1e9 / (double)median : 0.0);
+    fflush(out);
+    return true;
+}
+
+static bool parse_count(char const* s, uint64_t* value) {
+    char* end;
+    if(s[0] < '0' || s[0] > '9') {
+        return false;
+    }
+    *value = strtoull(s, &end, 10);
+    return *end == '\0';
+}
+
+//reads a comma separated list of sizes.
+static bool parse_sizes(char const* s, uint64_t* sizes, size_t* count) {
+    *count = 0;
+    while(*s != '\0') {
+        char* end;
+        if(*count == MAX_SIZES || s[0] < '0' || s[0] > '9') {
+            return false;
+        }
+        sizes[(*count)++] = strtoull(s, &end, 10);
+        if(*end == ',') {
+            end++;
+        } else if(*end != '\0') {
+            return false;
+        }
+        s = end;
+    }
+    return *count > 0;
+}
+
+static void print_usage(char const* program) {
+    printf("Usage: %s [options]\n"
+           "\n"
+           "Times the engines and vector operations, and prints the stats as JSON.\n"
+           "\n"
+           "Options:\n"
+           "  --sizes N,N,...    The sizes to run each benchmark at. Default 100000,1000000,10000000.\n"
+           "  --warmup W         Untimed runs before the timed ones. Default %d.\n"
+           "  --repetitions R    Timed runs. Default %d.\n"
+           "  --filter TEXT      Only run the benchmarks with TEXT in their name.\n"
+           "  --out PATH         Where to write the JSON. Default stdout.\n"
+           "  --list             Print the benchmark names and exit.\n"
+           "  --help             Print this and exit.\n",
+           program, DEFAULT_WARMUP, DEFAULT_REPETITIONS);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t sizes[MAX_SIZES] = {100000, 1000000, 10000000};
+    size_t size_count = 3;
+    uint64_t warmup = DEFAULT_WARMUP;
+    uint64_t repetitions = DEFAULT_REPETITIONS;
+    char const* filter = NULL;
+    char const* out_path = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        char const* arg = argv[i];
+        if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if(strcmp(arg, "--list") == 0) {
+            for(size_t j = 0; j < BENCHMARK_COUNT; j++) {
+                printf("%s\n", BENCHMARKS[j].name);
+            }
+            return 0;
+        }
+        if(i + 1 >= argc) {
+            fprintf(stderr, "Error: unknown argument %s\n", arg);
+            return -1;
+        }
+        char const* value = argv[i + 1];
+        bool ok = true;
+        if(strcmp(arg, "--sizes") == 0) {
+            ok = parse_sizes(value, sizes, &size_count);
+        } else if(strcmp(arg, "--warmup") == 0) {
+            ok = parse_count(value, &warmup) && warmup <= 1000;
+        } else if(strcmp(arg, "--repetitions") == 0) {
+            ok = parse_count(value, &repetitions) && repetitions >= 1 && repetitions <= 100000;
+        } else if(strcmp(arg, "--filter") == 0) {
+            filter = value;
+        } else if(strcmp(arg, "--out") == 0) {
+            out_path = value;
+        } else {
+            fprintf(stderr, "Error: unknown argument %s\n", arg);
+            return -1;
+        }
+        if(!ok) {
+            fprintf(stderr, "Error: %s can't be %s (see --help)\n", arg, value);
+            return -1;
+        }
+        i++;
+    }
+
+    FILE* out = out_path != NULL ? fopen(out_path, "w") : stdout;
+    BenchState state = {.sink = 0};
+    state.null_stream = fopen("/dev/null", "w");
+    uint64_t* times = malloc((warmup + repetitions) * sizeof(uint64_t));
+    if(out == NULL || state.null_stream == NULL || times == NULL) {
+        fprintf(stderr, "Error: couldn't set up the benchmarks\n");
+        return -1;
+    }
+
+    //what the numbers were measured with, so results from different machines aren't compared blindly.
+    fprintf(out, "{\n  \"benchmark\": \"filtered-primes-bench\",\n  \"warmup\": %" PRIu64 ",\n"
+                 "  \"repetitions\": %" PRIu64 ",\n  \"threads\": %zu,\n  \"trial_kernel\": \"%s\",\n"
+                 "  \"results\": [",
+            warmup, repetitions, parallel_sieve_default_thread_count(),
+            trial_kernel_name(trial_kernel_supported(TRIAL_KERNEL_AVX512) ? TRIAL_KERNEL_AVX512
+                              : trial_kernel_supported(TRIAL_KERNEL_AVX2) ? TRIAL_KERNEL_AVX2
+                              : TRIAL_KERNEL_SCALAR));
+    bool first = true;
+    bool ok = true;
+    for(size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        Benchmark const* b = &BENCHMARKS[i];
+        if(filter != NULL && strstr(b->name, filter) == NULL) {
+            continue;
+        }
+        for(size_t j = 0; j < size_count; j++) {
+            if(b->max_size != 0 && sizes[j] > b->max_size) {
+                continue;
+            }
+            if(run_benchmark(b, sizes[j], (unsigned)warmup, (unsigned)repetitions, &state, times, out, first)) {
+                first = false;
+            } else {
+                ok = false;
+            }
+        }
+    }
+    //printed so the work can't be optimized away, and as a sanity check between runs.
+    fprintf(out, "\n  ],\n  \"checksum\": %" PRIu64 "\n}\n", state.sink);
+
+    free(times);
+    fclose(state.null_stream);
+    if(out != stdout) {
+        fclose(out);
+    }
+    return ok ? 0 : -1;
+}
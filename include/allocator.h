@@ -0,0 +1,149 @@
+#ifndef FILTERED_PRIMES_ALLOCATOR_H
+#define FILTERED_PRIMES_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// Where vectors get their memory from, when it shouldn't be straight from malloc.
+///
+/// A `CaveAllocator` is a set of alloc, realloc, free and discard functions plus a context pointer they're all
+/// handed. The vectors made by `CAVE_TYPED_VEC()` take one (see typed-vec.h); `CaveVec` can't, since its memory
+/// is managed inside the Cave library.
+///
+/// Besides plain malloc, there are two allocators here, and page-allocator.h has a third:
+/// * `CaveArena` - a bump allocator over one block. Allocating is a bounds check and an add, freeing is a no-op,
+///   and everything is given back at once by `cave_arena_reset()`. For a set of buffers that all live and die
+///   together.
+/// * `CavePool` - a fixed number of fixed size blocks, handed out and taken back through a free list. For
+///   buffers that come and go but never outgrow a known size.
+///
+/// Neither is thread safe; give each thread its own.
+
+/// Every allocation from an arena or pool is aligned to this, which suits any type.
+#define CAVE_ALLOCATOR_ALIGNMENT (_Alignof(max_align_t))
+
+/// A source of memory.
+///
+/// Each function is handed `context` as its first argument. `realloc` and `free` are also told the size the
+/// allocation was made with, which the arena and pool make use of. `realloc` returns NULL and leaves the
+/// allocation as it was if it can't grow it.
+///
+/// `discard`, which may be NULL, is told that the contents of an allocation are no longer needed, though the
+/// allocation itself is, so the memory behind it can be given back to the system until it's next written.
+/// Afterwards the allocation reads as zeroes (or as whatever it held, if nothing was given back).
+typedef struct CaveAllocator {
+    void* (*alloc)(void* context, size_t bytes);
+    void* (*realloc)(void* context, void* ptr, size_t old_bytes, size_t new_bytes);
+    void (*free)(void* context, void* ptr, size_t bytes);
+    void (*discard)(void* context, void* ptr, size_t bytes);
+    void* context;
+} CaveAllocator;
+
+/// The allocator that just calls malloc, realloc and free.
+extern CaveAllocator const cave_malloc_allocator;
+
+
+/// A bump allocator over one block of memory.
+///
+/// None of the fields should be modified directly.
+typedef struct CaveArena {
+    unsigned char* base;
+    size_t capacity;
+    /// The number of bytes handed out so far.
+    size_t used;
+    /// Where the most recent allocation starts, so it alone can be grown or freed in place.
+    size_t last;
+} CaveArena;
+
+/// \brief Initializes `a` with a block of `capacity` bytes.
+///
+/// \param a - The arena to initialize.
+/// \param capacity - The number of bytes the arena can hand out. Must not be zero.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `a` is NULL or `capacity` is zero.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If the block could not be allocated.
+/// \return `a` on success, NULL if there is an error.
+CaveArena* cave_arena_init(CaveArena* a, size_t capacity, CaveError* err);
+
+/// \brief `bytes` bytes from the arena, aligned to `CAVE_ALLOCATOR_ALIGNMENT`.
+///
+/// \param a - The target arena.
+/// \param bytes - The number of bytes wanted.
+/// \return The memory, or NULL if the arena doesn't have that many bytes left.
+void* cave_arena_alloc(CaveArena* a, size_t bytes);
+
+/// \brief Takes back everything the arena has handed out, invalidating it all.
+///
+/// \param a - The target arena.
+void cave_arena_reset(CaveArena* a);
+
+/// \brief Frees the arena's block.
+///
+/// \param a - The target arena.
+void cave_arena_release(CaveArena* a);
+
+/// \brief An allocator that allocates from `a`.
+///
+/// Growing the most recent allocation grows it in place; growing any other allocation moves it to the end of
+/// the arena, and the old space isn't reused until the arena is reset.
+///
+/// \param a - The arena, which must outlive everything allocated from it.
+/// \return The allocator.
+CaveAllocator cave_arena_allocator(CaveArena* a);
+
+
+/// A fixed number of blocks of the same size.
+///
+/// None of the fields should be modified directly.
+typedef struct CavePool {
+    unsigned char* blocks;
+    /// The size of a block, rounded up to `CAVE_ALLOCATOR_ALIGNMENT`.
+    size_t block_size;
+    size_t block_count;
+    /// The first free block. Each free block starts with a pointer to the next.
+    void* free_list;
+} CavePool;
+
+/// \brief Initializes `p` with `block_count` blocks of at least `block_size` bytes each, all free.
+///
+/// \param p - The pool to initialize.
+/// \param block_size - The most bytes an allocation from the pool can be. Must not be zero.
+/// \param block_count - The number of blocks. Must not be zero.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `p` is NULL, or `block_size` or `block_count` is zero.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If the blocks could not be allocated.
+/// \return `p` on success, NULL if there is an error.
+CavePool* cave_pool_init(CavePool* p, size_t block_size, size_t block_count, CaveError* err);
+
+/// \brief A free block from the pool.
+///
+/// \param p - The target pool.
+/// \return The block, or NULL if none are free.
+void* cave_pool_alloc(CavePool* p);
+
+/// \brief Gives a block back to the pool.
+///
+/// \param p - The target pool.
+/// \param block - A block from `cave_pool_alloc()` (may be NULL).
+void cave_pool_free(CavePool* p, void* block);
+
+/// \brief Frees the pool's blocks, whether or not they were given back.
+///
+/// \param p - The target pool.
+void cave_pool_release(CavePool* p);
+
+/// \brief An allocator that allocates from `p`.
+///
+/// Allocations of more than `p->block_size` bytes fail, as does growing one past it.
+///
+/// \param p - The pool, which must outlive everything allocated from it.
+/// \return The allocator.
+CaveAllocator cave_pool_allocator(CavePool* p);
+
+#endif //FILTERED_PRIMES_ALLOCATOR_H
@@ -0,0 +1,110 @@
+#ifndef FILTERED_PRIMES_BASE_PRIMES_H
+#define FILTERED_PRIMES_BASE_PRIMES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// The table of small primes that everything else divides or sieves by.
+///
+/// Checking whether a number below `upperbound` is prime only ever needs the primes up to
+/// sqrt(upperbound), and for any 64-bit bound those all fit in 32 bits. So they are kept in a table of
+/// their own, separate from wherever results are stored, at 4 bytes a prime. For the default bound that's
+/// the primes below 113,512, about 42KB, which stays in L1/L2 cache while the hot loops walk it.
+
+
+/// Precomputed constants for testing whether a number is divisible by an odd prime `p` with a multiply
+/// and a compare, rather than a 64-bit division.
+///
+/// Multiplying by `p`'s inverse mod 2^64 shuffles the uint64_t's around one-to-one, and sends the multiples
+/// of `p` (0, p, 2p, ...) to 0, 1, 2, ... So `n` is a multiple of `p` exactly when `n * inverse` comes out
+/// no bigger than the number of multiples of `p` there are, `UINT64_MAX / p`.
+typedef struct BaseDivisor {
+    /// p^-1 mod 2^64.
+    uint64_t inverse;
+    /// UINT64_MAX / p.
+    uint64_t limit;
+} BaseDivisor;
+
+/// The primes needed to test numbers below some bound.
+///
+/// When the table is no longer needed, call `base_primes_release()` on it to free the memory.
+/// None of the fields should be modified directly.
+typedef struct BasePrimes {
+    /// uint32_t. Every prime up to and including `limit`, ascending.
+    CaveVec primes;
+    /// The largest number whose square is less than the bound the table was made for.
+    uint32_t limit;
+    /// BaseDivisor. Empty unless `base_primes_init_divisors()` has been called, after which
+    /// `divisors[i]` goes with `primes[i]`. The entry for 2 is unused, as 2 has no inverse.
+    CaveVec divisors;
+} BasePrimes;
+
+
+/// \brief Initializes `b` with every prime `p` where `p * p < upperbound`.
+///
+/// \param b - The table to initialize.
+/// \param upperbound - The bound the table has to be able to test numbers below.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `b` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+/// \return `b` on success, NULL if there is an error.
+BasePrimes* base_primes_init(BasePrimes* b, uint64_t upperbound, CaveError* err);
+
+/// \brief Works out the `BaseDivisor` for every prime in `b`.
+///
+/// These take 16 bytes a prime on top of the primes' 4, so they're only made for the paths that divide.
+///
+/// \param b - An initialized table.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `b` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+/// \return `b` on success, NULL if there is an error.
+BasePrimes* base_primes_init_divisors(BasePrimes* b, CaveError* err);
+
+/// \brief Frees the memory held by `b`.
+///
+/// \param b - The target table.
+void base_primes_release(BasePrimes* b);
+
+/// \brief Pointer to the first prime in the table. There are `b->primes.len` of them.
+///
+/// \param b - The target table.
+/// \return A pointer to the primes.
+static inline uint32_t const* base_primes_data(BasePrimes const* b) {
+    return b->primes.data;
+}
+
+/// \brief Whether `n` is divisible by the prime `d` was made for.
+///
+/// \param d - The divisor's constants.
+/// \param n - The number to test.
+/// \return true if `n` is a multiple of the prime.
+static inline bool base_divisor_divides(BaseDivisor d, uint64_t n) {
+    return n * d.inverse <= d.limit;
+}
+
+/// \brief The largest `r` such that `r * r <= n`.
+///
+/// The double square root can be off by one either way for big `n`, so it's corrected with exact integer math.
+///
+/// \param n - The number to take the square root of.
+/// \return The integer square root of `n`.
+static inline uint64_t isqrt_u64(uint64_t n) {
+    uint64_t r = (uint64_t)sqrt((double)n);
+    while(r > 0 && r > n / r) {
+        r--;
+    }
+    while(r + 1 <= n / (r + 1)) {
+        r++;
+    }
+    return r;
+}
+
+#endif //FILTERED_PRIMES_BASE_PRIMES_H
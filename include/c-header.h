@@ -0,0 +1,46 @@
+#ifndef FILTERED_PRIMES_C_HEADER_H
+#define FILTERED_PRIMES_C_HEADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// Writes the filtered list out as a C header, so it can be compiled straight into another program.
+///
+/// The header holds the list as a `static const uint64_t` array, and the bound, growth factor and count as
+/// macros (named with the given prefix, in upper case, and then the array in lower case):
+///
+///     #define FILTERED_PRIMES_BOUND UINT64_C(12884901888)
+///     #define FILTERED_PRIMES_GROWTH (1.5)
+///     #define FILTERED_PRIMES_COUNT (54)
+///     static const uint64_t filtered_primes[FILTERED_PRIMES_COUNT] = { ... };
+///
+/// The build uses this to generate the header for the `filtered-primes-table` target (see CMakeLists.txt).
+
+/// The prefix used when none is given.
+#define C_HEADER_DEFAULT_PREFIX ("filtered_primes")
+
+/// \brief Writes `values` to a C header at `path`.
+///
+/// The header is written to `path` with ".tmp" on the end and renamed into place, so a build never picks up
+/// half of one.
+///
+/// \param path - Where to write the header.
+/// \param values - A vector of uint64_t. Must not be empty, as C doesn't allow empty arrays.
+/// \param bound - The bound the values were found below.
+/// \param growth - The growth factor the values were filtered by.
+/// \param prefix - The name of the array. The macros are named with it in upper case. Must be a valid C
+///                 identifier, made of letters, digits and underscores.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `path`, `values` or `prefix` is NULL, `values` is empty, or `prefix`
+///                                       isn't a valid identifier.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+///                   * CAVE_FILE_ERROR - If the file could not be written.
+/// \return true on success, false if there is an error.
+bool c_header_write(char const* path, CaveVec const* values, uint64_t bound, double growth, char const* prefix,
+                    CaveError* err);
+
+#endif //FILTERED_PRIMES_C_HEADER_H
@@ -117,6 +117,45 @@ void cave_vec_release(CaveVec* v);
 /// \returns `v` if successful, and `NULL` if there is an error.
 CaveVec* cave_vec_push(CaveVec* v, void const* element, CaveError* err);
 
+/// \brief Copies `count` elements onto the end of `v->data`, reallocating at most once, and increasing
+/// `v->len` by `count`.
+///
+/// Like calling `cave_vec_push()` on each element in turn, but with one capacity check and one copy for the
+/// lot. If `v` has to grow, it grows by at least `CAVE_VEC_GROW_FACTOR`, so appending a batch at a time
+/// stays amortized constant time per element.
+///
+/// NOTE: defined in filtered-primes (src/cave-bedrock-ext.c) until Cave has it.
+///
+/// \param v - Target vector to act on.
+/// \param elements - A pointer to the objects to copy into `v->data`. `count * v->stride` bytes will be copied.
+///                   May be NULL if `count` is 0.
+/// \param count - The number of elements to copy.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL, or `elements` is NULL and `count` is not 0.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If `v` needs to realloc to accommodate the elements,
+///                   but the reallocation is unsuccessful. `v` is left as it was.
+/// \returns `v` if successful, and `NULL` if there is an error.
+CaveVec* cave_vec_push_n(CaveVec* v, void const* elements, size_t count, CaveError* err);
+
+/// \brief Copies every element of `src` onto the end of `dest`.
+///
+/// Equivalent to calling `cave_vec_push_n(dest, src->data, src->len, err)`.
+///
+/// NOTE: defined in filtered-primes (src/cave-bedrock-ext.c) until Cave has it.
+///
+/// \param dest - Target vector to act on.
+/// \param src - The vector to copy the elements of. Must have the same stride as `dest`, and must not be `dest`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `dest` or `src` is NULL, `src` is `dest`, or their strides differ.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If `dest` needs to realloc to accommodate the elements,
+///                   but the reallocation is unsuccessful.
+/// \returns `dest` if successful, and `NULL` if there is an error.
+CaveVec* cave_vec_append(CaveVec* dest, CaveVec const* src, CaveError* err);
+
 /// \brief The primary way to access and modify an element of the vector.
 ///
 /// \param v - The target vector.
@@ -345,7 +384,6 @@ CaveVec* cave_vec_map(CaveVec* dest, CaveVec const * src, size_t output_stride,
 
 /*
  * needs:
- * append
  * split_at
  * split_by
  * remove_indexes
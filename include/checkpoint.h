@@ -0,0 +1,150 @@
+#ifndef FILTERED_PRIMES_CHECKPOINT_H
+#define FILTERED_PRIMES_CHECKPOINT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "sieve.h"
+
+/// \file
+/// Saving how far a run has got, so a run that dies partway (out of time on a shared machine, say) can pick
+/// back up from there rather than from 0.
+///
+/// Every generator hands out primes in ascending order, so everything a run has done comes down to a
+/// position (every prime below it has gone through the pipeline and none above it has), the pipeline's
+/// count and filtered list, and how much of the all primes output has been written. A `Checkpoint` is just
+/// that, and it's saved as a short text file:
+///
+///     filtered-primes checkpoint 1
+///     bound 12884901888
+///     growth 0x1.8p+0
+///     position 1073741825
+///     count 54400028
+///     output table 54400028 14695981039346656037 1073741789
+///     filtered 45
+///     2
+///     3
+///     ...
+///
+/// The output line is "none", "text" and the number of bytes written, or "table" and the writer's count,
+/// checksum and last value (see prime-table.h). The checkpoint is written to a temporary file, synced, and
+/// renamed into place, so the file at the path is always a whole checkpoint.
+///
+/// A `CheckpointStage` sits in front of the pipeline and saves a checkpoint every so often, between batches.
+/// All it does per batch is read the clock, so it costs nothing next to finding the batch.
+
+/// The version of the format written. Bumped whenever the layout changes.
+#define CHECKPOINT_VERSION (1)
+/// How often checkpoints are saved when no interval is given, in seconds.
+#define CHECKPOINT_DEFAULT_INTERVAL (60)
+
+/// What has been written of the all primes output.
+typedef enum CheckpointOutput {
+    /// There isn't one.
+    CHECKPOINT_OUTPUT_NONE,
+    /// Text (see text-writer.h). `output_length` is the number of bytes written.
+    CHECKPOINT_OUTPUT_TEXT,
+    /// A table (see prime-table.h). `output_length`, `output_checksum` and `output_last` are the writer's
+    /// count, checksum and last value.
+    CHECKPOINT_OUTPUT_TABLE,
+} CheckpointOutput;
+
+/// How far a run has got.
+typedef struct Checkpoint {
+    /// The run's bound.
+    uint64_t bound;
+    /// The run's growth factor.
+    double growth;
+    /// Every prime below this has been seen, and none from it on.
+    uint64_t position;
+    /// The number of primes below `position`.
+    uint64_t count;
+    /// uint64_t. Every prime below `position` the filter kept, starting with 2. Not owned by the checkpoint.
+    CaveVec* filtered;
+    CheckpointOutput output;
+    uint64_t output_length;
+    uint64_t output_checksum;
+    uint64_t output_last;
+} Checkpoint;
+
+/// A closure that is called when a checkpoint is due, with every prime below `position` having gone through.
+///
+/// It should fill in and save a `Checkpoint`. If it sets `err` to anything other than `CAVE_NO_ERROR`, the
+/// run stops.
+typedef void (*CHECKPOINT_SAVE_CLOSURE)(uint64_t position, void* closure_data, CaveError* err);
+
+/// Passes batches on, and calls a `CHECKPOINT_SAVE_CLOSURE` every so often between them.
+///
+/// None of the fields should be modified directly.
+typedef struct CheckpointStage {
+    /// Every batch is handed on to this closure.
+    PRIME_BATCH_CLOSURE next;
+    /// Passed to `next` as its closure data.
+    void* next_data;
+    CHECKPOINT_SAVE_CLOSURE save;
+    /// Passed to `save` as its closure data.
+    void* save_data;
+    /// Every prime below this has been handed on.
+    uint64_t position;
+    /// Seconds between checkpoints.
+    double interval;
+    /// When the next checkpoint is due, in seconds on the monotonic clock.
+    double due;
+} CheckpointStage;
+
+
+/// \brief Saves `c` to `path`.
+///
+/// \param c - The checkpoint to save.
+/// \param path - Where to save it. Anything already there is replaced, once the new checkpoint is complete.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `c`, `c->filtered` or `path` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+///                   * CAVE_FILE_ERROR - If writing, syncing or renaming fails.
+/// \return true on success, false if there is an error.
+bool checkpoint_save(Checkpoint const* c, char const* path, CaveError* err);
+
+/// \brief Loads the checkpoint at `path` into `c`.
+///
+/// \param c - The checkpoint to fill.
+/// \param path - The checkpoint file.
+/// \param filtered - An initialized and empty vector of uint64_t that the filtered list is pushed onto.
+///                   `c->filtered` is set to it.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `c`, `path` or `filtered` is NULL, `filtered` isn't empty, or the
+///                                       file isn't a checkpoint of a version this program understands.
+///                   * CAVE_FILE_ERROR - If the file could not be opened.
+///                   * any error from pushing onto `filtered`.
+/// \return `c` on success, NULL if there is an error.
+Checkpoint* checkpoint_load(Checkpoint* c, char const* path, CaveVec* filtered, CaveError* err);
+
+/// \brief Initializes `s` to hand batches on to `next`, and call `save` every `interval` seconds.
+///
+/// The first checkpoint is due `interval` seconds from now.
+///
+/// \param s - The stage to initialize.
+/// \param position - Every prime below this has already been seen, as when resuming from a checkpoint.
+/// \param interval - Seconds between checkpoints.
+/// \param next - The closure every batch is handed on to.
+/// \param next_data - Closure data for `next` (may be NULL).
+/// \param save - The closure that saves a checkpoint.
+/// \param save_data - Closure data for `save` (may be NULL).
+/// \return `s`
+CheckpointStage* checkpoint_stage_init(CheckpointStage* s, uint64_t position, double interval,
+                                       PRIME_BATCH_CLOSURE next, void* next_data,
+                                       CHECKPOINT_SAVE_CLOSURE save, void* save_data);
+
+/// \brief The `PRIME_BATCH_CLOSURE` that hands a batch on, then saves a checkpoint if one is due.
+/// `closure_data` is the `CheckpointStage`.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `CheckpointStage*`.
+/// \param[out] err - The error recording argument. Set to any error from the next closure or from saving.
+void checkpoint_stage_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+#endif //FILTERED_PRIMES_CHECKPOINT_H
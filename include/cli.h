@@ -0,0 +1,101 @@
+#ifndef FILTERED_PRIMES_CLI_H
+#define FILTERED_PRIMES_CLI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "wheel.h"
+
+/// \file
+/// The command line options, so a run can be configured without recompiling. Run with `--help` for the list.
+
+/// The bound used when none is given: the number of bytes in 12 GB. Chosen because it's a pretty large
+/// number that I can also check all numbers below in less than a day.
+#define CLI_DEFAULT_BOUND ((uint64_t)12884901888)
+
+/// How the primes are found.
+typedef enum CliEngine {
+    /// The segmented sieve on a pool of threads (see parallel-sieve.h).
+    CLI_ENGINE_PARALLEL,
+    /// The segmented sieve on the calling thread (see sieve.h).
+    CLI_ENGINE_SIEVE,
+    /// Trial division (see trial-division.h).
+    CLI_ENGINE_TRIAL,
+    /// Straight to the filtered list with Miller-Rabin, without finding every prime (see direct-filter.h).
+    CLI_ENGINE_DIRECT,
+    /// Just count the primes, without finding them or filtering (see prime-count.h).
+    CLI_ENGINE_COUNT,
+} CliEngine;
+
+/// How lists are written out.
+typedef enum CliFormat {
+    /// Every number followed by " , ", then a newline (see text-writer.h).
+    CLI_FORMAT_TEXT,
+    /// A table file (see prime-table.h).
+    CLI_FORMAT_BINARY,
+    /// A C header (see c-header.h). Only for the filtered list.
+    CLI_FORMAT_C_HEADER,
+} CliFormat;
+
+/// Everything the command line can set.
+typedef struct CliOptions {
+    /// Primes strictly less than this are considered.
+    uint64_t bound;
+    /// The growth factor to filter by (see growth-filter.h).
+    double growth;
+    CliEngine engine;
+    /// The number of worker threads for the parallel engine. 0 for one per online processor.
+    size_t threads;
+    /// The sieve's segment size in bytes. 0 for `SIEVE_DEFAULT_SEGMENT_BYTES`.
+    size_t segment_bytes;
+    /// The wheel the sieve and trial division draw candidates from.
+    WheelKind wheel;
+    /// Where the filtered list is written. Defaults to a name that depends on `format`.
+    char const* out;
+    CliFormat format;
+    /// If not NULL, every prime found is also written here, in `format`.
+    char const* all_primes_out;
+    /// If not NULL, checkpoints are saved here as the run goes (see checkpoint.h).
+    char const* checkpoint;
+    /// Seconds between checkpoints.
+    double checkpoint_interval;
+    /// Whether to carry on from the checkpoint at `checkpoint`.
+    bool resume;
+    /// Whether to print progress lines to stderr as the run goes (see progress.h).
+    bool progress;
+    /// Seconds between progress lines.
+    double progress_interval;
+    /// Whether to print the usage and exit.
+    bool help;
+} CliOptions;
+
+
+/// \brief Fills `o` with the defaults: the default bound and growth factor, the parallel engine with one
+/// thread per processor and the default segment size, the mod 210 wheel, text to out.txt, and no checkpoints or
+/// progress lines.
+///
+/// \param o - The options to fill.
+void cli_options_default(CliOptions* o);
+
+/// \brief Reads the command line into `o`, on top of whatever is already there.
+///
+/// \param o - The options to fill. Usually filled with `cli_options_default()` first.
+/// \param argc - The number of arguments, including the program name.
+/// \param argv - The arguments.
+/// \param errors - Where to describe what's wrong with the arguments, if anything is.
+/// \return true if the arguments make sense, false if not.
+bool cli_parse(CliOptions* o, int argc, char* argv[], FILE* errors);
+
+/// \brief Prints the usage to `stream`.
+///
+/// \param stream - Where to print.
+/// \param program - The name the program was run as.
+void cli_print_usage(FILE* stream, char const* program);
+
+/// \brief The name of `engine` as given on the command line.
+///
+/// \param engine - The engine to name.
+/// \return A string literal.
+char const* cli_engine_name(CliEngine engine);
+
+#endif //FILTERED_PRIMES_CLI_H
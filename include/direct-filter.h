@@ -0,0 +1,30 @@
+#ifndef FILTERED_PRIMES_DIRECT_FILTER_H
+#define FILTERED_PRIMES_DIRECT_FILTER_H
+
+#include <stdint.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// Builds the filtered list without finding every prime below the bound.
+///
+/// The filter only ever wants the first prime past `growth` times the last one it kept, so rather than
+/// walking every prime, this jumps straight to that point and searches upwards with Miller-Rabin until it
+/// finds a prime the filter keeps. There are only a few dozen primes in the list, and the gaps between
+/// primes are short, so the whole list takes milliseconds, and the bound can go all the way to 2^64.
+
+
+/// \brief Pushes onto `filtered` exactly the primes the growth filter keeps out of all the primes less
+/// than `upperbound`, starting with 2.
+///
+/// \param filtered - An initialized vector of uint64_t.
+/// \param upperbound - Only primes strictly less than this are considered. 2 is always pushed.
+/// \param growth - The growth factor, see growth-filter.h.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `filtered` is NULL.
+///                   * any error from pushing onto `filtered`.
+/// \return `filtered` on success, NULL if there is an error.
+CaveVec* direct_filtered_primes_below(CaveVec* filtered, uint64_t upperbound, double growth, CaveError* err);
+
+#endif //FILTERED_PRIMES_DIRECT_FILTER_H
@@ -0,0 +1,151 @@
+#ifndef FILTERED_PRIMES_FILE_VEC_H
+#define FILTERED_PRIMES_FILE_VEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// A vector that lives in a file instead of in malloc'd memory.
+///
+/// A `CaveVec` of every prime below the default bound is about 4.6GB, and growing one by reallocating briefly
+/// needs the old and new buffers at once, which is more memory than a lot of machines have. A `CaveFileVec`
+/// instead maps a file into memory and grows by growing the file (which is sparse, so the space isn't used
+/// until it's written) and remapping it, so nothing is ever copied. The kernel writes pages back to the file
+/// and drops them as it needs the memory, so a vector bigger than memory just gets slower rather than failing,
+/// and once the vector is released, its elements are sitting in the file, as a plain array of them.
+///
+/// Apart from where it lives, it works like a `CaveVec`, and `cave_file_vec_as_vec()` gives a `CaveVec` view of
+/// it for the `cave_vec` functions that don't grow or free the vector.
+
+/// A vector of elements of the same size, kept in a memory mapped file.
+///
+/// When the vector is no longer needed, call `cave_file_vec_release()` on it, which leaves the file holding
+/// exactly its elements. None of the fields should be modified directly.
+typedef struct CaveFileVec {
+    /// `vec.data` is the start of the mapping, and `vec.capacity` is how many elements the file has room for.
+    CaveVec vec;
+    /// The file, open for reading and writing.
+    int fd;
+} CaveFileVec;
+
+
+/// \brief Initializes `v` as an empty vector in a new file at `path`.
+///
+/// \param v - The vector to initialize.
+/// \param path - Where to put the file. Anything already there is replaced.
+/// \param element_size - The number of bytes an element takes. Must not be zero.
+/// \param initial_capacity - The number of elements to make room for. If 0, `CAVE_VEC_DEFAULT_CAPACITY`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` or `path` is NULL, or `element_size` is zero.
+///                   * CAVE_FILE_ERROR - If the file could not be created, sized or mapped.
+/// \return `v` on success, NULL if there is an error.
+CaveFileVec* cave_file_vec_init(CaveFileVec* v, char const* path, size_t element_size, size_t initial_capacity,
+                                CaveError* err);
+
+/// \brief Makes sure `v` has room for at least `capacity` elements, growing the file if it doesn't.
+///
+/// Pointers into `v` may be invalidated, as the mapping can move.
+///
+/// \param v - The target vector.
+/// \param capacity - The number of elements to make room for.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL.
+///                   * CAVE_FILE_ERROR - If the file could not be grown or remapped. `v`'s elements and
+///                     capacity are left as they were, but the file may be left longer than its capacity, if
+///                     it couldn't be cut back down, until `cave_file_vec_release()` cuts it to the elements.
+/// \return `v` on success, NULL if there is an error.
+CaveFileVec* cave_file_vec_reserve(CaveFileVec* v, size_t capacity, CaveError* err);
+
+/// \brief Copies `element` onto the end of `v`, growing it by `CAVE_VEC_GROW_FACTOR` if it's full.
+///
+/// \param v - The target vector.
+/// \param element - The element to copy. `v->vec.stride` bytes are copied from it.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` or `element` is NULL.
+///                   * any error from `cave_file_vec_reserve()`.
+/// \return `v` on success, NULL if there is an error.
+CaveFileVec* cave_file_vec_push(CaveFileVec* v, void const* element, CaveError* err);
+
+/// \brief Copies `count` elements onto the end of `v`, growing it at most once.
+///
+/// \param v - The target vector.
+/// \param elements - The elements to copy, `count * v->vec.stride` bytes of them.
+/// \param count - The number of elements.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL, or `elements` is NULL and `count` isn't 0.
+///                   * any error from `cave_file_vec_reserve()`.
+/// \return `v` on success, NULL if there is an error.
+CaveFileVec* cave_file_vec_push_n(CaveFileVec* v, void const* elements, size_t count, CaveError* err);
+
+/// \brief A pointer to the element at `index`.
+///
+/// \param v - The target vector.
+/// \param index - The index of the element.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL.
+///                   * CAVE_INDEX_ERROR - If `index` is not less than the length of `v`.
+/// \return The element, which may be read and written until `v` is next grown, or NULL if there is an error.
+void* cave_file_vec_at(CaveFileVec const* v, size_t index, CaveError* err);
+
+/// \brief A pointer to the element at `index`, without checking `index`.
+///
+/// \param v - The target vector.
+/// \param index - The index of the element. Must be less than the length of `v`.
+/// \return The element, which may be read and written until `v` is next grown.
+static inline void* cave_file_vec_at_unchecked(CaveFileVec const* v, size_t index) {
+    return (unsigned char*)v->vec.data + v->vec.stride * index;
+}
+
+/// \brief `v` as a `CaveVec`, for the `cave_vec` functions that neither grow nor free it, such as
+/// `cave_vec_at()`, `cave_vec_foreach()` and `cave_vec_filter()`, or as the source of `cave_vec_map()`.
+///
+/// \param v - The target vector.
+/// \return A view of `v`, valid until `v` is next grown.
+static inline CaveVec* cave_file_vec_as_vec(CaveFileVec* v) {
+    return &v->vec;
+}
+
+/// \brief The `PRIME_BATCH_CLOSURE` that appends a batch to a vector of uint64_t. `closure_data` is the
+/// `CaveFileVec`.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `CaveFileVec*` to append to.
+/// \param[out] err - The error recording argument. Set to any error from `cave_file_vec_push_n()`.
+void cave_file_vec_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+/// \brief Writes everything in `v` back to its file, and waits for it to get there.
+///
+/// \param v - The target vector.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If syncing fails.
+/// \return true on success, false if there is an error.
+bool cave_file_vec_sync(CaveFileVec* v, CaveError* err);
+
+/// \brief Unmaps `v`, and cuts its file down to exactly its elements.
+///
+/// The file is closed whether or not this succeeds.
+///
+/// \param v - The target vector.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If the file could not be cut down or closed.
+/// \return true on success, false if there is an error.
+bool cave_file_vec_release(CaveFileVec* v, CaveError* err);
+
+#endif //FILTERED_PRIMES_FILE_VEC_H
@@ -0,0 +1,30 @@
+#ifndef FILTERED_PRIMES_GROWTH_FILTER_H
+#define FILTERED_PRIMES_GROWTH_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// \file
+/// The rule for which primes make it into the filtered list. Starting from 2, a prime is kept if it is
+/// more than `growth` times the last prime that was kept.
+///
+/// Every way of producing the filtered list goes through `growth_filter_keeps()`, so that they all
+/// agree right down to how the comparison rounds.
+
+/// The growth factor the filtered list is built with.
+#define GROWTH_FILTER_DEFAULT_FACTOR (1.5)
+
+/// \brief Whether `prime` is kept, given that `prev_prime` was the last prime kept.
+///
+/// The comparison is done in floating point, the way the filter always has, so that growth factors
+/// like 1.5 work without any fuss.
+///
+/// \param prime - The prime being considered.
+/// \param prev_prime - The last prime that was kept.
+/// \param growth - The growth factor.
+/// \return true if `prime` is kept.
+static inline bool growth_filter_keeps(uint64_t prime, uint64_t prev_prime, double growth) {
+    return (double)prime > growth * (double)prev_prime;
+}
+
+#endif //FILTERED_PRIMES_GROWTH_FILTER_H
@@ -0,0 +1,169 @@
+#ifndef FILTERED_PRIMES_HASHMAP_H
+#define FILTERED_PRIMES_HASHMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// The hashmap this whole program was written for.
+///
+/// Its capacities are the filtered primes: the table grows from one prime in filtered-primes-table.h to the
+/// next, each at least `FILTERED_PRIMES_GROWTH` times the last. A prime capacity means a slot is picked with
+/// `hash % capacity`, which mixes in every bit of the hash, so even a weak hash spreads out. The catch is that
+/// `%` by a number only known at runtime is a division, which takes tens of cycles and would be most of the
+/// cost of a lookup. So the map works out a Lemire "fastmod" constant whenever its capacity changes, which
+/// turns the remainder into three multiplies.
+///
+/// Collisions are resolved by linear probing. Each slot has a control byte, kept in an array of their own,
+/// which is either empty, a tombstone, or 7 bits of the hash of the key in the slot. A probe walks the control
+/// bytes, 64 to a cache line, and only looks at a key when its 7 bits match, so a miss usually costs one
+/// cache line and no key comparisons at all. A slot's key and value sit next to each other, and are
+/// prefetched while its control byte is read, so a hit usually costs two cache lines, fetched at once.
+///
+/// Keys and values are any fixed size, set when the map is initialized, like a `CaveVec`'s elements.
+
+/// The most slots (counting tombstones) that may be in use before the table grows, as a fraction.
+#define CAVE_HASHMAP_MAX_LOAD_NUMERATOR (3)
+#define CAVE_HASHMAP_MAX_LOAD_DENOMINATOR (4)
+/// The number of slots the map has room for when no initial capacity is given. Rounded up to a filtered prime.
+#define CAVE_HASHMAP_DEFAULT_CAPACITY (16)
+
+
+/// \brief The precomputed constant for `cave_fastmod()` by `d`.
+///
+/// \param d - The divisor. Must not be 0 or 1.
+/// \return The constant.
+static inline unsigned __int128 cave_fastmod_constant(uint64_t d) {
+    return ~(unsigned __int128)0 / d + 1;
+}
+
+/// \brief `a % d`, without dividing. From Lemire, Kaser and Kurz, "Faster Remainder by Direct Computation".
+///
+/// \param a - The dividend.
+/// \param m - `cave_fastmod_constant(d)`.
+/// \param d - The divisor.
+/// \return `a % d`.
+static inline uint64_t cave_fastmod(uint64_t a, unsigned __int128 m, uint64_t d) {
+    //the fractional part of a / d, as a 128 bit fixed point number, times d.
+    unsigned __int128 fraction = m * a;
+    unsigned __int128 low = (unsigned __int128)(uint64_t)fraction * d;
+    unsigned __int128 high = (fraction >> 64) * d;
+    return (uint64_t)((high + (low >> 64)) >> 64);
+}
+
+
+typedef uint64_t (*CAVE_HASH_CLOSURE)(void const* key, size_t key_size, void* closure_data);
+typedef bool (*CAVE_EQUALS_CLOSURE)(void const* a, void const* b, size_t key_size, void* closure_data);
+
+/// A hashmap from fixed size keys to fixed size values.
+///
+/// When the map is no longer needed, call `cave_hashmap_release()` on it to free the memory.
+/// None of the fields should be modified directly.
+typedef struct CaveHashMap {
+    /// One per slot: 0 if it's empty, 1 if it's a tombstone, otherwise 0x80 and 7 bits of its key's hash.
+    uint8_t* control;
+    /// One per slot: the key, then the value at `value_offset`, padded out to `entry_size`.
+    unsigned char* entries;
+    size_t key_size;
+    size_t value_size;
+    size_t value_offset;
+    size_t entry_size;
+    /// The number of slots, which is always a filtered prime.
+    uint64_t capacity;
+    /// `cave_fastmod_constant(capacity)`.
+    unsigned __int128 fastmod;
+    /// Where `capacity` is in the filtered prime table.
+    size_t capacity_index;
+    /// The number of keys in the map.
+    size_t len;
+    size_t tombstones;
+    CAVE_HASH_CLOSURE hash;
+    CAVE_EQUALS_CLOSURE equals;
+    void* closure_data;
+} CaveHashMap;
+
+
+/// \brief The hash the map uses when none is given. Good enough for any key, and fast for 8 byte ones.
+///
+/// \param key - The key.
+/// \param key_size - The size of the key in bytes.
+/// \param closure_data - Unused.
+/// \return The hash.
+uint64_t cave_hash_bytes(void const* key, size_t key_size, void* closure_data);
+
+/// \brief Initializes `m` as an empty map.
+///
+/// \param m - The map to initialize.
+/// \param key_size - The number of bytes a key takes. Must not be zero.
+/// \param value_size - The number of bytes a value takes. May be zero, to use the map as a set.
+/// \param initial_capacity - The number of keys to make room for without growing. If 0,
+///                           `CAVE_HASHMAP_DEFAULT_CAPACITY`.
+/// \param hash - The hash of a key. If NULL, `cave_hash_bytes()`.
+/// \param equals - Whether two keys are equal. If NULL, they're compared byte for byte.
+/// \param closure_data - Passed to `hash` and `equals` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `m` is NULL or `key_size` is zero.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If the slots could not be allocated, or there is no
+///                     filtered prime big enough for `initial_capacity`.
+/// \return `m` on success, NULL if there is an error.
+CaveHashMap* cave_hashmap_init(CaveHashMap* m, size_t key_size, size_t value_size, size_t initial_capacity,
+                               CAVE_HASH_CLOSURE hash, CAVE_EQUALS_CLOSURE equals, void* closure_data,
+                               CaveError* err);
+
+/// \brief Sets the value of `key` to `value`, adding `key` if it isn't already there.
+///
+/// Pointers into the map may be invalidated, as it can grow.
+///
+/// \param m - The target map.
+/// \param key - The key, `m->key_size` bytes of it.
+/// \param value - The value, `m->value_size` bytes of it (may be NULL if `m->value_size` is zero).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `m` or `key` is NULL, or `value` is NULL and `m->value_size` isn't 0.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If the map needed to grow and couldn't. It is left as
+///                     it was.
+/// \return The value as stored in the map (or the key, if `m->value_size` is zero), valid until the map is next
+///         changed, or NULL if there is an error.
+void* cave_hashmap_insert(CaveHashMap* m, void const* key, void const* value, CaveError* err);
+
+/// \brief The value of `key`.
+///
+/// \param m - The target map.
+/// \param key - The key to look up.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `m` or `key` is NULL.
+///                   * CAVE_INDEX_ERROR - If `key` isn't in the map.
+/// \return The value as stored in the map (or the key, if `m->value_size` is zero), which may be written to
+///         until the map is next changed, or NULL if there is an error.
+void* cave_hashmap_get(CaveHashMap const* m, void const* key, CaveError* err);
+
+/// \brief Removes `key` from the map.
+///
+/// \param m - The target map.
+/// \param key - The key to remove.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `m` or `key` is NULL.
+///                   * CAVE_INDEX_ERROR - If `key` isn't in the map.
+/// \return true if the key was removed, false if there is an error.
+bool cave_hashmap_remove(CaveHashMap* m, void const* key, CaveError* err);
+
+/// \brief Removes every key, keeping the capacity.
+///
+/// \param m - The target map.
+void cave_hashmap_clear(CaveHashMap* m);
+
+/// \brief Frees the map's memory.
+///
+/// \param m - The target map.
+void cave_hashmap_release(CaveHashMap* m);
+
+#endif //FILTERED_PRIMES_HASHMAP_H
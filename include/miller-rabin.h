@@ -0,0 +1,27 @@
+#ifndef FILTERED_PRIMES_MILLER_RABIN_H
+#define FILTERED_PRIMES_MILLER_RABIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// \file
+/// Deterministic Miller-Rabin primality testing for 64-bit integers.
+///
+/// Miller-Rabin is normally probabilistic, but for numbers below 2^64 a fixed set of seven bases is
+/// known to catch every composite, so the answer here is exact. Unlike trial division it doesn't need
+/// any list of smaller primes, so it can check a single number anywhere below 2^64 on its own.
+
+
+/// \brief Checks whether `n` is prime.
+///
+/// \param n - The number to check.
+/// \return true if `n` is prime.
+bool miller_rabin_is_prime(uint64_t n);
+
+/// \brief Finds the smallest prime greater than or equal to `n`.
+///
+/// \param n - Where to start looking.
+/// \return The prime, or 0 if there is no prime between `n` and `UINT64_MAX`.
+uint64_t miller_rabin_next_prime(uint64_t n);
+
+#endif //FILTERED_PRIMES_MILLER_RABIN_H
@@ -0,0 +1,73 @@
+#ifndef FILTERED_PRIMES_PAGE_ALLOCATOR_H
+#define FILTERED_PRIMES_PAGE_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "allocator.h"
+
+/// \file
+/// An allocator that maps memory straight from the system, a page at a time, with control over the pages.
+///
+/// A vector of every prime below the default bound is about 4.6GB, which is over a million 4KB pages: a page
+/// fault for each the first time it's written, and a TLB miss for most reads when it's walked in any order
+/// but straight through. A `CavePageAllocator` can instead ask for huge pages (2MB on x86-64, so 512 times
+/// fewer of both), and can fault the pages in up front rather than as they're first written. Discarding an
+/// allocation (as clearing a vector does) hands its pages back to the system with `MADV_DONTNEED`, and
+/// shrinking one unmaps its tail.
+///
+/// Growing an allocation is done with `mremap()` on Linux, which extends the mapping or moves its page tables
+/// rather than copying it. Growing a 2GB vector with realloc copies 2GB and needs 6GB while it does; growing
+/// one from a `CavePageAllocator` copies nothing and needs 4GB, and only as the new half is written.
+///
+/// What each option costs and saves is measured by the `page_vec` benchmarks in filtered-primes-bench.
+
+/// Which pages a `CavePageAllocator` maps.
+typedef enum CaveHugePages {
+    /// The system's normal pages.
+    CAVE_HUGE_PAGES_NONE,
+    /// Normal pages marked with `MADV_HUGEPAGE`, so the kernel backs them with transparent huge pages where it
+    /// can. Works without any setup, as long as transparent huge pages aren't turned off entirely.
+    CAVE_HUGE_PAGES_TRANSPARENT,
+    /// Pages from the reserved huge page pool, with `MAP_HUGETLB`. The pool is usually empty unless
+    /// vm.nr_hugepages has been set, and when a mapping can't be had from it, the allocator falls back to
+    /// `CAVE_HUGE_PAGES_TRANSPARENT`.
+    CAVE_HUGE_PAGES_EXPLICIT,
+} CaveHugePages;
+
+/// Maps allocations straight from the system.
+///
+/// Allocations are rounded up to whole pages, huge ones if huge pages were asked for, so it's for a few big
+/// allocations rather than many small ones. It is thread safe. None of the fields should be modified directly.
+typedef struct CavePageAllocator {
+    CaveHugePages huge_pages;
+    /// Whether mappings are faulted in when they're made.
+    bool prefault;
+    /// What allocations are rounded up to.
+    size_t page_size;
+} CavePageAllocator;
+
+
+/// \brief Initializes `a`.
+///
+/// Huge pages and prefaulting are only available on Linux. Elsewhere they're quietly ignored.
+///
+/// \param a - The allocator to initialize.
+/// \param huge_pages - Which pages to map.
+/// \param prefault - Whether to fault in each mapping when it's made, with `MAP_POPULATE`. This makes the
+///                   mapping slower and its first writes faster, and means its memory is taken straight away.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `a` is NULL or `huge_pages` isn't one of the `CaveHugePages`.
+/// \return `a` on success, NULL if there is an error.
+CavePageAllocator* cave_page_allocator_init(CavePageAllocator* a, CaveHugePages huge_pages, bool prefault,
+                                            CaveError* err);
+
+/// \brief An allocator that allocates with `a`'s options.
+///
+/// \param a - The page allocator, which must outlive everything allocated with it.
+/// \return The allocator.
+CaveAllocator cave_page_allocator(CavePageAllocator* a);
+
+#endif //FILTERED_PRIMES_PAGE_ALLOCATOR_H
@@ -0,0 +1,86 @@
+#ifndef FILTERED_PRIMES_PARALLEL_SIEVE_H
+#define FILTERED_PRIMES_PARALLEL_SIEVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "sieve.h"
+
+/// \file
+/// Runs the segmented sieve from sieve.h on a pool of threads.
+///
+/// `[0, upperbound)` is cut into chunks of a few segments each. Chunks are dealt out round-robin onto
+/// a deque per worker. A worker takes chunks from the front of its own deque, and when that runs dry it
+/// steals from the back of another worker's deque, so a worker that gets held up doesn't hold everyone
+/// else up with it.
+///
+/// Each chunk's primes are written into their own buffer, and the calling thread stitches the buffers
+/// back together in chunk order. Only a fixed window of chunks is ever handed out ahead of the one being
+/// stitched, so memory use stays bounded however far ahead the fast workers get.
+
+/// The number of segments sieved together as one unit of work.
+#define PARALLEL_SIEVE_SEGMENTS_PER_CHUNK (8)
+/// How many chunks per thread may be in flight (handed out but not yet stitched) at once.
+#define PARALLEL_SIEVE_CHUNKS_PER_THREAD (4)
+
+
+/// \brief The number of threads to use when none is specified, which is the number of online processors.
+size_t parallel_sieve_default_thread_count(void);
+
+/// \brief Pushes every prime less than `upperbound` onto `primes`, in ascending order, using `thread_count`
+/// worker threads.
+///
+/// The primes pushed are exactly those `sieve_primes_below()` would push.
+/// Just a convenience over `parallel_sieve_foreach_batch()`.
+///
+/// \param primes - An initialized vector of uint64_t.
+/// \param upperbound - Primes strictly less than this are pushed.
+/// \param segment_bytes - See `sieve_init()`.
+/// \param wheel - See `sieve_init()`.
+/// \param thread_count - The number of worker threads. If 0, `parallel_sieve_default_thread_count()` is used.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `primes` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+///                   * CAVE_UNKNOWN_ERROR - If a thread could not be started.
+/// \return `primes` on success, NULL if there is an error.
+CaveVec* parallel_sieve_primes_below(CaveVec* primes, uint64_t upperbound, size_t segment_bytes,
+                                     WheelKind wheel, size_t thread_count, CaveError* err);
+
+/// \brief Finds every prime less than `upperbound` using `thread_count` worker threads, and hands them to `fn`
+/// in batches, in ascending order.
+///
+/// `fn` is always called from the calling thread, one batch at a time, so it needs no locking of its own.
+/// The batches are handed over in order, so concatenating them gives exactly the primes
+/// `sieve_primes_below()` would push. If `fn` sets an error, sieving stops and that error is returned.
+///
+/// \param upperbound - Primes strictly less than this are found.
+/// \param segment_bytes - See `sieve_init()`.
+/// \param wheel - See `sieve_init()`.
+/// \param thread_count - The number of worker threads. If 0, `parallel_sieve_default_thread_count()` is used.
+/// \param fn - The closure each batch is passed to. The batch is only valid for the duration of the call.
+/// \param closure_data - Passed as the third argument to each invocation of `fn` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `fn` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+///                   * CAVE_UNKNOWN_ERROR - If a thread could not be started.
+///                   * any error that is set by `fn`.
+/// \return true on success, false if there is an error.
+bool parallel_sieve_foreach_batch(uint64_t upperbound, size_t segment_bytes, WheelKind wheel, size_t thread_count,
+                                  PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err);
+
+/// \brief The same as `parallel_sieve_foreach_batch()`, but only for the primes from `start` on.
+///
+/// Used to pick a run back up where it left off (see checkpoint.h). The chunks before the one holding
+/// `start` are never sieved.
+///
+/// \param start - Only primes greater than or equal to this are found.
+/// \return true on success, false if there is an error.
+bool parallel_sieve_foreach_batch_from(uint64_t start, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                                       size_t thread_count, PRIME_BATCH_CLOSURE fn, void* closure_data,
+                                       CaveError* err);
+
+#endif //FILTERED_PRIMES_PARALLEL_SIEVE_H
@@ -0,0 +1,89 @@
+#ifndef FILTERED_PRIMES_PARALLEL_VEC_H
+#define FILTERED_PRIMES_PARALLEL_VEC_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// `cave_vec_foreach()`, `cave_vec_filter()` and `cave_vec_map()`, spread over several threads.
+///
+/// The vector is cut into one contiguous range per thread, and each thread runs the closure over its own range,
+/// so a pass over hundreds of millions of primes runs at the speed of every core rather than one. The calling
+/// thread takes the first range itself.
+///
+/// * foreach - each thread applies the closure to its range in place.
+/// * map - each thread writes its range of the output, which lines up with its range of the input.
+/// * filter - each thread compacts the elements it keeps to the front of its own range, counting them. A prefix
+///   sum of the counts then says where each range's elements go, and each range's are moved down into place on
+///   a thread of its own, so the elements kept stay in the order they were in. A range whose destination is
+///   still holding an earlier range's elements waits for those to move first, so when most elements are kept
+///   the moves can end up one after another; when few are, they all happen at once.
+///
+/// The closure is called from several threads at once, so anything it does to `closure_data` has to be
+/// thread safe. Within a range, elements are visited first to last, but the ranges are visited concurrently.
+/// If the closure sets an error, the other threads stop soon after, and the error is reported as the serial
+/// function would report it. If several set one, the error from the earliest range wins.
+
+/// A range is never made smaller than this many elements, so short vectors aren't spread over more threads
+/// than they're worth.
+#define PARALLEL_VEC_MIN_RANGE (16384)
+
+
+/// \brief Applies `fn` in place to every element of `v`, using up to `thread_count` threads.
+///
+/// \param v - The target vector.
+/// \param thread_count - The most threads to use, counting the calling one. If 0, one per processor.
+/// \param fn - The closure that gets applied to each element. Must be safe to call from several threads.
+/// \param closure_data - Parameter that gets passed as second argument to each invocation of `fn`.
+///                       (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL or `fn` is NULL.
+///                   * any error that is set by `fn`. Some elements may have been visited and some not.
+/// \return `v` on success, NULL if an error is encountered.
+CaveVec* cave_vec_parallel_foreach(CaveVec* v, size_t thread_count, CAVE_FOREACH_CLOSURE fn, void* closure_data,
+                                   CaveError* err);
+
+/// \brief Keeps only the elements of `v` that `fn` returns true for, in order, using up to `thread_count`
+/// threads.
+///
+/// \param v - The target vector.
+/// \param thread_count - The most threads to use, counting the calling one. If 0, one per processor.
+/// \param fn - The closure that decides whether to keep each element. Must be safe to call from several threads.
+/// \param closure_data - Parameter that gets passed as second argument to each invocation of `fn`.
+///                       (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` is NULL or `fn` is NULL.
+///                   * any error that is set by `fn`. The length of `v` is unchanged, but elements may have
+///                     been moved within it.
+/// \return `v` on success, NULL if an error is encountered.
+CaveVec* cave_vec_parallel_filter(CaveVec* v, size_t thread_count, CAVE_FILTER_CLOSURE fn, void* closure_data,
+                                  CaveError* err);
+
+/// \brief Initializes `dest` and fills it with `fn` applied to every element of `src`, using up to `thread_count`
+/// threads.
+///
+/// `dest` MUST be uninitialized, as this function will initialize it and fill it.
+///
+/// \param dest - Pointer to the uninitialized vector that will hold the output of every call to `fn`.
+/// \param src - Pointer to the vector that will have its elements iterated over.
+/// \param output_stride - The size in bytes of the output element.
+/// \param thread_count - The most threads to use, counting the calling one. If 0, one per processor.
+/// \param fn - The closure that gets applied to each element. Must be safe to call from several threads.
+/// \param closure_data - Parameter that gets passed as third argument to each invocation of `fn`.
+///                       (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `dest`, `src` or `fn` is NULL, or `output_stride` is zero.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If `dest` could not be allocated.
+///                   * any error that is set by `fn`. `dest` is left uninitialized.
+/// \return `dest` on success, NULL if an error is encountered.
+CaveVec* cave_vec_parallel_map(CaveVec* dest, CaveVec const* src, size_t output_stride, size_t thread_count,
+                               CAVE_MAP_CLOSURE fn, void* closure_data, CaveError* err);
+
+#endif //FILTERED_PRIMES_PARALLEL_VEC_H
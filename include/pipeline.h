@@ -0,0 +1,79 @@
+#ifndef FILTERED_PRIMES_PIPELINE_H
+#define FILTERED_PRIMES_PIPELINE_H
+
+#include <stdint.h>
+#include "cave-bedrock.h"
+#include "sieve.h"
+
+/// \file
+/// Streams primes from a generator straight into the growth filter, without ever holding the full list.
+///
+/// The generators (the sieves and trial division) hand out primes a batch at a time, in ascending order,
+/// through a `PRIME_BATCH_CLOSURE`. A `PrimePipeline` is such a closure. It counts every prime, runs them
+/// through the growth filter, and optionally passes each batch on to one more closure (to write the primes
+/// out, say). The only memory any of it needs is the batch in flight, rather than every prime below the bound.
+
+
+/// The state of the stages every prime flows through.
+///
+/// `count`, `prev_prime` and `filtered` may be read at any time, but should not be modified directly.
+typedef struct PrimePipeline {
+    /// The number of primes seen so far.
+    uint64_t count;
+    /// The growth factor the filter keeps primes by (see growth-filter.h).
+    double growth;
+    /// The last prime the filter kept.
+    uint64_t prev_prime;
+    /// uint64_t. Every prime the filter has kept, starting with 2.
+    CaveVec* filtered;
+    /// If not NULL, every batch is also handed on to this closure, after counting and filtering.
+    PRIME_BATCH_CLOSURE next;
+    /// Passed to `next` as its closure data.
+    void* next_data;
+} PrimePipeline;
+
+
+/// \brief Initializes `p` to filter into `filtered`, pushing 2 onto `filtered` as the filter's starting point.
+///
+/// \param p - The pipeline to initialize.
+/// \param filtered - An initialized and empty vector of uint64_t that the kept primes are pushed onto.
+/// \param growth - The growth factor to filter by.
+/// \param next - Optional closure every batch is handed on to (may be NULL).
+/// \param next_data - Closure data for `next` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `p` or `filtered` is NULL.
+///                   * any error from pushing onto `filtered`.
+/// \return `p` on success, NULL if there is an error.
+PrimePipeline* prime_pipeline_init(PrimePipeline* p, CaveVec* filtered, double growth,
+                                   PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err);
+
+/// \brief Initializes `p` to carry on from where an earlier pipeline left off, such as one saved in a checkpoint.
+///
+/// \param p - The pipeline to initialize.
+/// \param filtered - A vector of uint64_t holding every prime the earlier pipeline's filter kept, starting with 2.
+/// \param growth - The growth factor to filter by. Should be the one the earlier pipeline used.
+/// \param count - The number of primes the earlier pipeline saw.
+/// \param next - Optional closure every batch is handed on to (may be NULL).
+/// \param next_data - Closure data for `next` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `p` or `filtered` is NULL, or `filtered` is empty.
+/// \return `p` on success, NULL if there is an error.
+PrimePipeline* prime_pipeline_resume(PrimePipeline* p, CaveVec* filtered, double growth, uint64_t count,
+                                     PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err);
+
+/// \brief The `PRIME_BATCH_CLOSURE` that feeds a batch through a pipeline. `closure_data` is the `PrimePipeline`.
+///
+/// Batches have to arrive in ascending order, as every generator hands them out.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `PrimePipeline*` to feed.
+/// \param[out] err - The error recording argument. Set to any error from pushing onto the filtered list,
+///                   or from the next closure.
+void prime_pipeline_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+#endif //FILTERED_PRIMES_PIPELINE_H
@@ -0,0 +1,28 @@
+#ifndef FILTERED_PRIMES_PRIME_COUNT_H
+#define FILTERED_PRIMES_PRIME_COUNT_H
+
+#include <stdint.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// Counts primes without finding them, using Lucy Hedgehog's variant of the Legendre/Meissel method.
+///
+/// For `n`, the count of numbers up to `v` that survive sieving by the primes up to `p` is only ever
+/// needed for the values `v = n / i`. There are only about 2 * sqrt(n) of those, and sieving by each
+/// prime `p` updates them all with one subtraction apiece. That takes about n^(3/4) / log(n) steps and
+/// 2 * sqrt(n) counts' worth of memory, so counting below 10^13 needs about 50MB and a few seconds,
+/// rather than enumerating 346 billion primes.
+
+
+/// \brief Counts the primes strictly less than `upperbound`.
+///
+/// \param upperbound - Primes strictly less than this are counted.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If the tables, 16 * sqrt(upperbound) bytes, can't be
+///                   allocated.
+/// \return The number of primes less than `upperbound`, or 0 if there is an error.
+uint64_t prime_count_below(uint64_t upperbound, CaveError* err);
+
+#endif //FILTERED_PRIMES_PRIME_COUNT_H
@@ -0,0 +1,136 @@
+#ifndef FILTERED_PRIMES_PRIME_STORE_H
+#define FILTERED_PRIMES_PRIME_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// A compact, append-only list of primes.
+///
+/// Storing every prime as a uint64_t costs 8 bytes apiece, which below 12884901888 comes to about 4.6GB.
+/// But consecutive primes are close together, and the gap between two odd primes is always even, so
+/// instead each prime is stored as half its gap from the previous prime, which fits in a single byte
+/// for every gap below 512 (true of every gap below about 3 * 10^17). Bigger gaps, and the odd gap
+/// from 2 to 3, are written as a 0 byte followed by the full gap as a LEB128 varint.
+///
+/// That only allows walking the list from the front, so every `PRIME_STORE_BLOCK_SIZE` primes the store
+/// also records the prime itself and where its block's gaps start. Getting at an arbitrary index then
+/// means decoding at most one block's worth of gaps.
+
+/// The number of primes per block. Each block costs 16 bytes of index on top of its gaps.
+#define PRIME_STORE_BLOCK_SIZE (256)
+
+/// Where a block of the store starts.
+typedef struct PrimeStoreBlock {
+    /// The first prime in the block. Its own gap is not stored.
+    uint64_t first;
+    /// The offset into `gaps` of the gap of the block's second prime.
+    uint64_t gap_offset;
+} PrimeStoreBlock;
+
+/// Holds a list of ascending primes (or really, any ascending uint64_t's) in roughly a byte apiece.
+///
+/// When the store is no longer needed, call `prime_store_release()` on it to free the memory.
+/// None of the fields should be modified directly.
+typedef struct PrimeStore {
+    /// uint8_t. The encoded gaps.
+    CaveVec gaps;
+    /// PrimeStoreBlock. One for every `PRIME_STORE_BLOCK_SIZE` primes.
+    CaveVec blocks;
+    /// The last prime pushed.
+    uint64_t last;
+    /// The number of primes in the store.
+    size_t len;
+} PrimeStore;
+
+/// Walks a `PrimeStore` from some index onwards.
+typedef struct PrimeStoreIter {
+    PrimeStore const* store;
+    /// The index of the prime the next call to `prime_store_iter_next()` returns.
+    size_t index;
+    /// The offset into `store->gaps` of that prime's gap.
+    size_t offset;
+    /// The prime before `index`. Unused at the start of a block.
+    uint64_t prev;
+} PrimeStoreIter;
+
+
+/// \brief Initializes `s` as an empty store.
+///
+/// \param s - The store to initialize.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `s` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+/// \return `s` on success, NULL if there is an error.
+PrimeStore* prime_store_init(PrimeStore* s, CaveError* err);
+
+/// \brief Frees the memory held by `s`.
+///
+/// \param s - The target store.
+void prime_store_release(PrimeStore* s);
+
+/// \brief Appends `prime` to the end of `s`.
+///
+/// \param s - The target store.
+/// \param prime - The prime to append. Must not be less than the last prime in `s`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `s` is NULL or `prime` is less than the last prime in `s`.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If growing `s` does not succeed.
+/// \return `s` on success, NULL if there is an error.
+PrimeStore* prime_store_push(PrimeStore* s, uint64_t prime, CaveError* err);
+
+/// \brief Appends `count` primes to the end of `s`.
+///
+/// \param s - The target store.
+/// \param primes - The primes to append, in ascending order, none less than the last prime in `s`.
+/// \param count - The number of primes in `primes`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `s` or `primes` is NULL, or `primes` is out of order.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If growing `s` does not succeed.
+/// \return `s` on success, NULL if there is an error. On error, the primes before the
+/// offending one have been appended.
+PrimeStore* prime_store_push_n(PrimeStore* s, uint64_t const* primes, size_t count, CaveError* err);
+
+/// \brief The prime at `index`.
+///
+/// Decodes at most `PRIME_STORE_BLOCK_SIZE` gaps. To go through the primes in order, use a `PrimeStoreIter`.
+///
+/// \param s - The target store.
+/// \param index - The index of the prime. Must be less than `s->len`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `s` is NULL.
+///                   * CAVE_INDEX_ERROR - If `index` is not less than `s->len`.
+/// \return The prime, or 0 if there is an error.
+uint64_t prime_store_at(PrimeStore const* s, size_t index, CaveError* err);
+
+/// \brief The number of bytes of memory `s` is holding.
+///
+/// \param s - The target store.
+/// \return The capacity of the gaps plus the capacity of the index.
+size_t prime_store_bytes(PrimeStore const* s);
+
+/// \brief Points `it` at `index` of `s`.
+///
+/// \param it - The iterator to initialize.
+/// \param s - The store to walk. Must outlive `it`, and not be pushed onto while `it` is in use.
+/// \param index - The index to start at. If it is `s->len` or more, the iterator starts out finished.
+/// \return `it`
+PrimeStoreIter* prime_store_iter_init(PrimeStoreIter* it, PrimeStore const* s, size_t index);
+
+/// \brief Gets the next prime out of `it`.
+///
+/// \param it - The target iterator.
+/// \param[out] prime - Where the prime is written.
+/// \return true if a prime was written, and false if the iterator has reached the end of the store.
+bool prime_store_iter_next(PrimeStoreIter* it, uint64_t* prime);
+
+#endif //FILTERED_PRIMES_PRIME_STORE_H
@@ -0,0 +1,260 @@
+#ifndef FILTERED_PRIMES_PRIME_TABLE_H
+#define FILTERED_PRIMES_PRIME_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// A binary file format for tables of primes (or filtered primes) that other programs can mmap and use as is.
+///
+/// The text output has to be parsed back before it's any use, and for every prime below the bound it would
+/// run to well over 100GB. A table file is instead a 64 byte header followed by the values as a plain
+/// little-endian array, so loading one is just mapping it, however big it is.
+///
+/// The header, with every field little-endian:
+///
+///     offset  size  field
+///          0     8  magic, "FPTABLE" and a 0 byte
+///          8     4  version, `PRIME_TABLE_VERSION`
+///         12     4  element width in bytes, 4 or 8
+///         16     8  bound, every value is less than this
+///         24     8  count, the number of values
+///         32     8  growth factor the values were filtered by, as an IEEE double. 0 if they weren't filtered.
+///         40     8  checksum of the values (see `prime_table_checksum_step()`)
+///         48    16  reserved, 0
+///
+/// The array starts at offset 64, so as long as the file is mapped at a page boundary (which mmap always
+/// does) the values are aligned.
+///
+/// The checksum starts at 0xcbf29ce484222325, and each value in turn, widened to 64 bits, is folded in with
+/// `checksum = (checksum ^ value) * 0x100000001b3`, modulo 2^64.
+///
+/// A table is written to a temporary file next to its path and renamed into place once it's complete, so a
+/// reader never sees half of one.
+
+/// The first 8 bytes of every table file.
+#define PRIME_TABLE_MAGIC ("FPTABLE")
+/// The version of the format written. Bumped whenever the layout changes.
+#define PRIME_TABLE_VERSION (1)
+/// The size of the header. The values start right after it.
+#define PRIME_TABLE_HEADER_BYTES (64)
+
+/// What the header of a table says.
+typedef struct PrimeTableHeader {
+    uint32_t version;
+    /// 4 or 8.
+    uint32_t element_width;
+    uint64_t bound;
+    uint64_t count;
+    double growth;
+    uint64_t checksum;
+} PrimeTableHeader;
+
+/// Writes a table file a batch at a time.
+///
+/// Open with `prime_table_writer_open()`, push values with `prime_table_writer_write()` (or hand it to a
+/// generator as the `PRIME_BATCH_CLOSURE` `prime_table_writer_consume()`), and finish with
+/// `prime_table_writer_close()`. None of the fields should be modified directly.
+typedef struct PrimeTableWriter {
+    FILE* file;
+    /// Where the table ends up.
+    char* path;
+    /// Where it's written until it's complete.
+    char* tmp_path;
+    /// The header so far. `count` and `checksum` are kept up to date as values are written.
+    PrimeTableHeader header;
+    /// The last value written, to check they ascend.
+    uint64_t last;
+} PrimeTableWriter;
+
+/// A table file mapped into memory.
+///
+/// When the table is no longer needed, call `prime_table_close()` on it to unmap it.
+/// None of the fields should be modified directly.
+typedef struct PrimeTable {
+    PrimeTableHeader header;
+    /// The whole file, as mapped.
+    void* map;
+    size_t map_bytes;
+    /// The values, `header.count` of them, each `header.element_width` bytes, little-endian.
+    unsigned char const* data;
+} PrimeTable;
+
+
+/// \brief Folds `value` into a running checksum.
+///
+/// The checksum is an FNV-style 64 bit word hash: FNV-1a's offset basis and prime, but with a whole value
+/// xored in per step rather than a byte, so it keeps up with the disk. That makes it not FNV-1a itself, and an
+/// FNV-1a tool won't reproduce it; the exact formula is in the format description above. It starts out as
+/// `PRIME_TABLE_CHECKSUM_SEED`.
+///
+/// \param checksum - The checksum of the values so far.
+/// \param value - The next value.
+/// \return The checksum including `value`.
+static inline uint64_t prime_table_checksum_step(uint64_t checksum, uint64_t value) {
+    return (checksum ^ value) * (uint64_t)0x100000001b3;
+}
+
+/// The checksum of no values.
+#define PRIME_TABLE_CHECKSUM_SEED ((uint64_t)0xcbf29ce484222325)
+
+/// \brief The smallest element width that fits every value below `bound`.
+///
+/// \param bound - The table's bound.
+/// \return 4 or 8.
+static inline uint32_t prime_table_width_for(uint64_t bound) {
+    return bound <= (uint64_t)UINT32_MAX + 1 ? 4 : 8;
+}
+
+/// \brief Starts writing a table to `path`.
+///
+/// Nothing is at `path` until `prime_table_writer_close()` succeeds. Until then the table is written to
+/// `path` with ".tmp" on the end.
+///
+/// \param w - The writer to initialize.
+/// \param path - Where to write the table.
+/// \param bound - Every value will be less than this.
+/// \param growth - The growth factor the values were filtered by, or 0 if they weren't.
+/// \param element_width - 4 or 8. Every value has to fit in this many bytes.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `w` or `path` is NULL, or `element_width` isn't 4 or 8.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+///                   * CAVE_FILE_ERROR - If the file could not be created.
+/// \return `w` on success, NULL if there is an error.
+PrimeTableWriter* prime_table_writer_open(PrimeTableWriter* w, char const* path, uint64_t bound, double growth,
+                                          uint32_t element_width, CaveError* err);
+
+/// \brief Appends `count` values to the table.
+///
+/// \param w - The target writer.
+/// \param values - The values, ascending, none less than the last value written, each less than the bound.
+/// \param count - The number of values.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `values` is out of order, not less than the bound, or doesn't fit
+///                                       the element width.
+///                   * CAVE_FILE_ERROR - If writing fails.
+/// \return `w` on success, NULL if there is an error.
+PrimeTableWriter* prime_table_writer_write(PrimeTableWriter* w, uint64_t const* values, size_t count, CaveError* err);
+
+/// \brief The `PRIME_BATCH_CLOSURE` that appends a batch to a table. `closure_data` is the `PrimeTableWriter`.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `PrimeTableWriter*` to append to.
+/// \param[out] err - The error recording argument. Set to any error from `prime_table_writer_write()`.
+void prime_table_writer_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+/// \brief Makes sure everything written so far is on disk, so the table can be picked back up with
+/// `prime_table_writer_resume()` even if the program dies.
+///
+/// \param w - The target writer.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If flushing fails.
+/// \return `w` on success, NULL if there is an error.
+PrimeTableWriter* prime_table_writer_flush(PrimeTableWriter* w, CaveError* err);
+
+/// \brief Picks up writing a table that was left unfinished, as it was when `header` and `last` were taken.
+///
+/// Whatever was written to the temporary file after that is cut off.
+///
+/// \param w - The writer to initialize.
+/// \param path - Where the table is being written, as passed to `prime_table_writer_open()`.
+/// \param header - The writer's `header` at the point to carry on from.
+/// \param last - The writer's `last` at the point to carry on from.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `w`, `path` or `header` is NULL, or the temporary file is shorter
+///                                       than `header` says, or isn't a table of the same bound and width.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+///                   * CAVE_FILE_ERROR - If the temporary file could not be opened or cut.
+/// \return `w` on success, NULL if there is an error.
+PrimeTableWriter* prime_table_writer_resume(PrimeTableWriter* w, char const* path, PrimeTableHeader const* header,
+                                            uint64_t last, CaveError* err);
+
+/// \brief Finishes the table, and moves it to its path.
+///
+/// The writer is released whether or not this succeeds. On failure, the temporary file is removed.
+///
+/// \param w - The target writer.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If writing the header, flushing, or renaming fails.
+/// \return true on success, false if there is an error.
+bool prime_table_writer_close(PrimeTableWriter* w, CaveError* err);
+
+/// \brief Releases the writer without finishing the table, and removes the temporary file.
+///
+/// \param w - The target writer.
+void prime_table_writer_abandon(PrimeTableWriter* w);
+
+/// \brief Writes every value in `values` to a table at `path`.
+///
+/// Just a convenience over `PrimeTableWriter`. The element width is `prime_table_width_for(bound)`.
+///
+/// \param path - Where to write the table.
+/// \param values - A vector of uint64_t, ascending, each less than `bound`.
+/// \param bound - See `prime_table_writer_open()`.
+/// \param growth - See `prime_table_writer_open()`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `values` is NULL, or any error from `prime_table_writer_write()`.
+///                   * any error from `prime_table_writer_open()` or `prime_table_writer_close()`.
+/// \return true on success, false if there is an error.
+bool prime_table_write(char const* path, CaveVec const* values, uint64_t bound, double growth, CaveError* err);
+
+/// \brief Maps the table at `path` into memory.
+///
+/// Only the header is read, so this takes the same time however big the table is, unless `verify` is set.
+///
+/// \param t - The table to initialize.
+/// \param path - The table file.
+/// \param verify - Whether to check the values against the checksum, which reads the whole file.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `t` or `path` is NULL, the file isn't a table of a version this
+///                                       program understands, its size doesn't match its header, or `verify`
+///                                       is set and the checksum doesn't match.
+///                   * CAVE_FILE_ERROR - If the file could not be opened or mapped.
+/// \return `t` on success, NULL if there is an error.
+PrimeTable* prime_table_open(PrimeTable* t, char const* path, bool verify, CaveError* err);
+
+/// \brief Unmaps `t`.
+///
+/// \param t - The target table.
+void prime_table_close(PrimeTable* t);
+
+//reads a little-endian value a byte at a time, so it reads right on any host. With a constant width,
+//compilers turn this into a single load.
+static inline uint64_t prime_table_load_le(unsigned char const* bytes, uint32_t width) {
+    uint64_t value = 0;
+    for(uint32_t i = 0; i < width; i++) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+/// \brief The value at `index` of `t`. `index` must be less than `t->header.count`.
+///
+/// \param t - The target table.
+/// \param index - The index of the value.
+/// \return The value.
+static inline uint64_t prime_table_at(PrimeTable const* t, uint64_t index) {
+    if(t->header.element_width == 8) {
+        return prime_table_load_le(t->data + index * 8, 8);
+    }
+    return prime_table_load_le(t->data + index * 4, 4);
+}
+
+#endif //FILTERED_PRIMES_PRIME_TABLE_H
@@ -0,0 +1,96 @@
+#ifndef FILTERED_PRIMES_PROGRESS_H
+#define FILTERED_PRIMES_PROGRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "cave-bedrock.h"
+#include "sieve.h"
+
+/// \file
+/// Reports how a run is going while it goes, so there's some way to tell whether it will take 3 hours or 30.
+///
+/// A `ProgressReporter` is a `PRIME_BATCH_CLOSURE` that sits in front of the rest of the pipeline. All it does
+/// per batch is store where the run has got to and how many primes it has seen, with relaxed atomics, which
+/// compile to plain stores. A thread of its own wakes up every so often, reads them, and prints a line like
+///
+///     progress: 33.3% (4294967296), 203280221 primes, 312M numbers/s, 14.8M primes/s, eta 0:00:27, rss 12.1MB
+///
+/// The rates are averaged over the whole run so far, so they (and the estimate) settle down as it goes.
+
+/// How often a line is printed when no interval is given, in seconds.
+#define PROGRESS_DEFAULT_INTERVAL (10)
+
+/// Prints progress lines from a thread of its own.
+///
+/// Start it with `progress_reporter_start()`, hand it to a generator as the `PRIME_BATCH_CLOSURE`
+/// `progress_reporter_consume()`, and stop it with `progress_reporter_stop()`.
+/// None of the fields should be modified directly.
+typedef struct ProgressReporter {
+    /// Every batch is handed on to this closure.
+    PRIME_BATCH_CLOSURE next;
+    /// Passed to `next` as its closure data.
+    void* next_data;
+    /// Where the lines are printed.
+    FILE* stream;
+    /// The run's bound.
+    uint64_t bound;
+    /// Seconds between lines.
+    double interval;
+    /// Where the run started, and how many primes it started with, so the rates only count this run's work.
+    uint64_t start_position;
+    uint64_t start_count;
+    /// When the reporter started, in seconds on the monotonic clock.
+    double start_time;
+
+    /// Every prime below this has been seen. Only written by the thread calling `progress_reporter_consume()`.
+    _Atomic uint64_t position;
+    /// The number of primes seen, including `start_count`.
+    _Atomic uint64_t count;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    /// Guarded by `lock`.
+    bool stopping;
+} ProgressReporter;
+
+
+/// \brief Initializes `r` and starts its thread, which prints a line to `stream` every `interval` seconds.
+///
+/// \param r - The reporter to start. Must stay where it is until `progress_reporter_stop()`.
+/// \param stream - Where to print, usually stderr so it doesn't mix with the output.
+/// \param bound - The run's bound.
+/// \param interval - Seconds between lines.
+/// \param position - Every prime below this has already been seen, as when resuming from a checkpoint.
+/// \param count - The number of primes already seen.
+/// \param next - The closure every batch is handed on to.
+/// \param next_data - Closure data for `next` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `r`, `stream` or `next` is NULL.
+///                   * CAVE_UNKNOWN_ERROR - If the thread could not be started.
+/// \return `r` on success, NULL if there is an error.
+ProgressReporter* progress_reporter_start(ProgressReporter* r, FILE* stream, uint64_t bound, double interval,
+                                          uint64_t position, uint64_t count,
+                                          PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err);
+
+/// \brief The `PRIME_BATCH_CLOSURE` that hands a batch on, then records how far the run has got.
+/// `closure_data` is the `ProgressReporter`.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `ProgressReporter*`.
+/// \param[out] err - The error recording argument. Set to any error from the next closure.
+void progress_reporter_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+/// \brief Stops `r`'s thread, and prints one last line.
+///
+/// \param r - The target reporter.
+/// \param position - Where the run finished, usually its bound.
+void progress_reporter_stop(ProgressReporter* r, uint64_t position);
+
+#endif //FILTERED_PRIMES_PROGRESS_H
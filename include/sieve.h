@@ -0,0 +1,191 @@
+#ifndef FILTERED_PRIMES_SIEVE_H
+#define FILTERED_PRIMES_SIEVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "wheel.h"
+#include "base-primes.h"
+
+/// \file
+/// A segmented Sieve of Eratosthenes.
+///
+/// A plain sieve needs a flag for every number below the upperbound, which for the bounds this
+/// program is run with is far more ram than I have. Instead the range is sieved one fixed-size
+/// segment at a time, so the only memory needed is the segment itself plus the primes up to
+/// sqrt(upperbound) that do the crossing off.
+///
+/// Only odd numbers are stored in a segment. Byte `j` of a segment starting at `low` stands for
+/// the number `low + 2*j + 1`, and `low` is always even.
+///
+/// On top of that, the sieve runs on a wheel (see wheel.h). Only multiples `p * k` where `k` is a
+/// candidate of the wheel are crossed off, and only the wheel's candidates are read back out of a
+/// segment, so the bytes for numbers sharing a factor with the wheel's modulus are never touched.
+
+/// The default number of bytes in a sieve segment. As each byte stands for one odd number,
+/// a segment covers twice this many integers. Sized to sit comfortably in L2 cache.
+#define SIEVE_DEFAULT_SEGMENT_BYTES (1 << 17)
+
+
+/// A closure that is handed primes a batch at a time, such as a segment's worth.
+///
+/// `primes` holds `count` primes in ascending order, and is only valid for the duration of the call.
+/// If the closure sets `err` to anything other than `CAVE_NO_ERROR`, whatever is producing the batches stops.
+typedef void (*PRIME_BATCH_CLOSURE)(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+/// \brief A `PRIME_BATCH_CLOSURE` that pushes every prime in the batch onto the vector of uint64_t passed
+/// as `closure_data`.
+void prime_batch_push(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+
+/// The state shared by everything sieving below a given upperbound.
+///
+/// Once initialized it is only ever read from, so any number of `SieveCursor`s may use it at once.
+/// None of the fields should be modified directly.
+typedef struct Sieve {
+    uint64_t upperbound;
+    size_t segment_bytes;
+    Wheel wheel;
+    /// Every prime `p` where `p * p < upperbound`.
+    BasePrimes base;
+    /// The index into `base` of the first prime that isn't one of the wheel's. The wheel's primes
+    /// never need crossing off, since their multiples are never read.
+    size_t first_sieving_prime;
+} Sieve;
+
+/// Where a base prime will next cross something off.
+typedef struct SieveMultiple {
+    /// The index into the next segment of the multiple.
+    uint64_t index;
+    /// The index into the wheel's residues of the multiple divided by the base prime,
+    /// mod the wheel's modulus.
+    uint32_t wheel_index;
+} SieveMultiple;
+
+/// Walks a range of a `Sieve` one segment at a time.
+///
+/// All fields should be treated as read only.
+typedef struct SieveCursor {
+    Sieve const* sieve;
+    /// The (even) number the next segment starts at.
+    uint64_t low;
+    /// One past the last number this cursor will sieve.
+    uint64_t high;
+    uint8_t* segment;
+    /// SieveMultiple. For each of the first `active` sieving primes (the base primes from
+    /// `first_sieving_prime` on), the next multiple of that prime that needs crossing off.
+    CaveVec multiples;
+    size_t active;
+} SieveCursor;
+
+
+/// \brief Initializes `s` and finds the base primes needed to sieve below `upperbound`.
+///
+/// \param s - The sieve to initialize.
+/// \param upperbound - Primes strictly less than `upperbound` will be found.
+/// \param segment_bytes - The size of the buffer each cursor sieves with. If 0, then
+///                        `SIEVE_DEFAULT_SEGMENT_BYTES` is used.
+/// \param wheel - Which wheel to sieve with.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `s` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If allocating the base primes fails.
+/// \return `s` on success, NULL if there is an error.
+Sieve* sieve_init(Sieve* s, uint64_t upperbound, size_t segment_bytes, WheelKind wheel, CaveError* err);
+
+/// \brief Frees the memory held by `s`. Every cursor using `s` must be released first.
+///
+/// \param s - The target sieve.
+void sieve_release(Sieve* s);
+
+/// \brief Initializes `c` to sieve the numbers in `[low, high)`.
+///
+/// `high` is clamped to `s->upperbound`, and `low` is rounded down to an even number.
+///
+/// \param c - The cursor to initialize.
+/// \param s - An initialized sieve that must outlive `c`.
+/// \param low - The first number to sieve.
+/// \param high - One past the last number to sieve.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `c` or `s` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If allocating the segment fails.
+/// \return `c` on success, NULL if there is an error.
+SieveCursor* sieve_cursor_init(SieveCursor* c, Sieve const* s, uint64_t low, uint64_t high, CaveError* err);
+
+/// \brief Points `c` at a new range `[low, high)`, keeping its buffers.
+///
+/// Equivalent to releasing and re-initializing `c` with the same sieve, without the reallocation.
+///
+/// \param c - The target cursor.
+/// \param low - The first number to sieve. Rounded down to an even number.
+/// \param high - One past the last number to sieve. Clamped to the sieve's upperbound.
+void sieve_cursor_seek(SieveCursor* c, uint64_t low, uint64_t high);
+
+/// \brief Sieves the next segment of `c`, pushing every prime found in it onto `primes` in ascending order.
+///
+/// \param c - The target cursor.
+/// \param primes - An initialized vector of uint64_t to push the primes onto.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `c` or `primes` is NULL.
+///                   * any error from pushing onto `primes`.
+/// \return true if a segment was sieved, and false once the cursor has reached `high` or if there is an error.
+bool sieve_cursor_next(SieveCursor* c, CaveVec* primes, CaveError* err);
+
+/// \brief Frees the memory held by `c`.
+///
+/// \param c - The target cursor.
+void sieve_cursor_release(SieveCursor* c);
+
+/// \brief Pushes every prime less than `upperbound` onto `primes`, in ascending order.
+///
+/// Just a convenience over a `Sieve` and a single `SieveCursor` spanning `[0, upperbound)`.
+///
+/// \param primes - An initialized vector of uint64_t.
+/// \param upperbound - Primes strictly less than this are pushed.
+/// \param segment_bytes - See `sieve_init()`.
+/// \param wheel - See `sieve_init()`.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `primes` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+/// \return `primes` on success, NULL if there is an error.
+CaveVec* sieve_primes_below(CaveVec* primes, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                            CaveError* err);
+
+/// \brief Finds every prime less than `upperbound` on the calling thread, and hands them to `fn` a segment at a time,
+/// in ascending order.
+///
+/// Only one segment's worth of primes is ever held at once.
+///
+/// \param upperbound - Primes strictly less than this are found.
+/// \param segment_bytes - See `sieve_init()`.
+/// \param wheel - See `sieve_init()`.
+/// \param fn - The closure each segment's primes are passed to.
+/// \param closure_data - Passed as the third argument to each invocation of `fn` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `fn` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+///                   * any error that is set by `fn`.
+/// \return true on success, false if there is an error.
+bool sieve_foreach_batch(uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                         PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err);
+
+/// \brief The same as `sieve_foreach_batch()`, but only for the primes from `start` on.
+///
+/// Used to pick a run back up where it left off (see checkpoint.h). Sieving starts right at `start`, so the
+/// primes before it are never found at all.
+///
+/// \param start - Only primes greater than or equal to this are found.
+/// \return true on success, false if there is an error.
+bool sieve_foreach_batch_from(uint64_t start, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                              PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err);
+
+#endif //FILTERED_PRIMES_SIEVE_H
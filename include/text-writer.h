@@ -0,0 +1,118 @@
+#ifndef FILTERED_PRIMES_TEXT_WRITER_H
+#define FILTERED_PRIMES_TEXT_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "cave-bedrock.h"
+
+/// \file
+/// Writes lists of uint64_t's out as text, fast.
+///
+/// `fprintf()` parses its format string and takes the stream's lock for every number, which caps it at
+/// a few tens of MB a second, far too slow to dump a list of every prime. A `TextWriter` instead turns
+/// numbers into decimal two digits at a time from a table, into a big buffer of its own, and hands the
+/// buffer to `write()` a MB at a time.
+///
+/// The output is exactly what `fprintf(stream, "%" PRIu64 " , ", n)` would give for each number.
+
+/// How much is buffered before writing.
+#define TEXT_WRITER_BUFFER_BYTES (1 << 20)
+
+/// Buffers text on its way to a file descriptor.
+///
+/// When the writer is no longer needed, call `text_writer_release()` on it, which also flushes it.
+/// None of the fields should be modified directly.
+typedef struct TextWriter {
+    /// The file descriptor written to. Not closed by the writer.
+    int fd;
+    /// `TEXT_WRITER_BUFFER_BYTES` of text waiting to be written.
+    char* buffer;
+    /// The number of bytes in `buffer`.
+    size_t len;
+} TextWriter;
+
+
+/// \brief Initializes `w` to write to `fd`.
+///
+/// Anything already buffered in a `FILE*` on the same descriptor has to be flushed first, or it will come
+/// out after this writer's text.
+///
+/// \param w - The writer to initialize.
+/// \param fd - An open file descriptor to write to.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `w` is NULL or `fd` is negative.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+/// \return `w` on success, NULL if there is an error.
+TextWriter* text_writer_init(TextWriter* w, int fd, CaveError* err);
+
+/// \brief Writes `count` numbers, each followed by " , ".
+///
+/// \param w - The target writer.
+/// \param values - The numbers to write.
+/// \param count - The number of numbers.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If writing fails.
+/// \return `w` on success, NULL if there is an error.
+TextWriter* text_writer_uint64s(TextWriter* w, uint64_t const* values, size_t count, CaveError* err);
+
+/// \brief Writes the string `s`, without its terminating 0.
+///
+/// \param w - The target writer.
+/// \param s - The string to write.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If writing fails.
+/// \return `w` on success, NULL if there is an error.
+TextWriter* text_writer_str(TextWriter* w, char const* s, CaveError* err);
+
+/// \brief Writes out everything buffered.
+///
+/// \param w - The target writer.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If writing fails.
+/// \return `w` on success, NULL if there is an error.
+TextWriter* text_writer_flush(TextWriter* w, CaveError* err);
+
+/// \brief The `PRIME_BATCH_CLOSURE` that writes a batch out as text. `closure_data` is the `TextWriter`.
+///
+/// \param primes - The batch of primes.
+/// \param count - The number of primes in the batch.
+/// \param closure_data - The `TextWriter*` to write to.
+/// \param[out] err - The error recording argument. Set to any error from `text_writer_uint64s()`.
+void text_writer_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err);
+
+/// \brief Flushes `w` and frees its buffer.
+///
+/// \param w - The target writer.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_FILE_ERROR - If the final flush fails. The buffer is freed either way.
+/// \return true on success, false if there is an error.
+bool text_writer_release(TextWriter* w, CaveError* err);
+
+/// \brief Writes every number in `v` to `stream`, each followed by " , ", then a newline.
+///
+/// Whatever `stream` already has buffered is flushed first, and the numbers go straight to its file
+/// descriptor through a `TextWriter`.
+///
+/// \param v - A vector of uint64_t.
+/// \param stream - Where to write.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `v` or `stream` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+///                   * CAVE_FILE_ERROR - If writing fails.
+/// \return true on success, false if there is an error.
+bool fprint_vec_of_uint64(CaveVec const* v, FILE* stream, CaveError* err);
+
+#endif //FILTERED_PRIMES_TEXT_WRITER_H
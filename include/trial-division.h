@@ -0,0 +1,71 @@
+#ifndef FILTERED_PRIMES_TRIAL_DIVISION_H
+#define FILTERED_PRIMES_TRIAL_DIVISION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "wheel.h"
+#include "base-primes.h"
+#include "sieve.h"
+
+/// \file
+/// The original way this program found primes: divide each candidate by the primes up to its square root,
+/// which come from a base prime table (see base-primes.h). Far slower than the sieve, but simple enough to trust, so it's kept around
+/// for small bounds and for checking the sieve's work.
+
+/// The number of primes handed over at a time by `trial_division_foreach_batch()`.
+#define TRIAL_DIVISION_BATCH_SIZE (4096)
+
+
+/// \brief Checks whether `num` is prime by dividing it by the primes in `base`.
+///
+/// \param num - The number to check. Must be greater than 1.
+/// \param base - A base prime table made for a bound greater than `num`, so that it holds every prime up
+///               to sqrt(num). `base_primes_init_divisors()` must have been called on it.
+/// \param skip - The number of primes at the front of `base` that `num` is already known not to
+///               be divisible by, such as the primes of the wheel `num` came from. Those are not checked.
+/// \return true if `num` is prime.
+bool check_if_prime(uint64_t num, BasePrimes const* base, size_t skip);
+
+/// \brief Pushes every prime less than `upperbound` onto `primes`, in ascending order, by trial division.
+///
+/// Only the candidates of the wheel `wheel` are checked.
+/// Just a convenience over `trial_division_foreach_batch()`.
+///
+/// \param primes - An initialized and empty vector of uint64_t.
+/// \param upperbound - Primes strictly less than this are pushed.
+/// \param wheel - Which wheel to draw the candidates from.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `primes` is NULL or not empty.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+///                   * any error from pushing onto `primes`.
+/// \return `primes` on success, NULL if there is an error.
+CaveVec* trial_division_primes_below(CaveVec* primes, uint64_t upperbound, WheelKind wheel, CaveError* err);
+
+/// \brief Finds every prime less than `upperbound` by trial division, and hands them to `fn` in batches of
+/// `TRIAL_DIVISION_BATCH_SIZE`, in ascending order.
+///
+/// \param upperbound - Primes strictly less than this are found.
+/// \param wheel - Which wheel to draw the candidates from.
+/// \param fn - The closure each batch is passed to.
+/// \param closure_data - Passed as the third argument to each invocation of `fn` (may be NULL).
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `fn` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If any allocation fails.
+///                   * any error that is set by `fn`.
+/// \return true on success, false if there is an error.
+bool trial_division_foreach_batch(uint64_t upperbound, WheelKind wheel,
+                                  PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err);
+
+/// \brief The same as `trial_division_foreach_batch()`, but only for the primes from `start` on.
+///
+/// \param start - Only primes greater than or equal to this are found.
+/// \return true on success, false if there is an error.
+bool trial_division_foreach_batch_from(uint64_t start, uint64_t upperbound, WheelKind wheel,
+                                       PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err);
+
+#endif //FILTERED_PRIMES_TRIAL_DIVISION_H
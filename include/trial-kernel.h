@@ -0,0 +1,130 @@
+#ifndef FILTERED_PRIMES_TRIAL_KERNEL_H
+#define FILTERED_PRIMES_TRIAL_KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cave-bedrock.h"
+#include "base-primes.h"
+
+/// \file
+/// Trial division a block of candidates at a time, with SIMD where the CPU has it.
+///
+/// `check_if_prime()` takes one candidate through every divisor in turn, and each step waits on the last.
+/// Going the other way around, one divisor across a block of candidates, every test is independent, so
+/// they can be done several to an instruction. Vectors don't have a 64-bit divide (or even, before
+/// AVX-512, a 64-bit multiply), so the kernels divide in floating point instead: every candidate is below
+/// 2^52, so it fits in a double exactly, and `n * (1/p)` rounded to the nearest integer is exactly `n / p`
+/// whenever `p` divides `n` (the error is under 1/p). So `n - round(n * (1/p)) * p`, which is done exactly,
+/// is 0 exactly when `p` divides `n`.
+///
+/// Most candidates have a small factor, while the rest, mostly primes, have to be tested all the way to their
+/// square root. So a block is first tested against the `TRIAL_KERNEL_FIRST_DIVISORS` smallest divisors, and
+/// only the survivors are gathered into blocks of their own to go through the rest, so that lanes aren't
+/// left idle on composites while the primes in the block finish.
+///
+/// Which kernel to use is decided at runtime, so the same binary runs anywhere.
+
+/// The most candidates tested together.
+#define TRIAL_KERNEL_BLOCK_SIZE (32)
+/// The number of divisors every candidate is tested against before the survivors are gathered up.
+#define TRIAL_KERNEL_FIRST_DIVISORS (32)
+/// Candidates must be below this for the vector kernels. Above it, the scalar kernel is always used.
+#define TRIAL_KERNEL_MAX_VALUE ((uint64_t)1 << 52)
+
+/// The ways a block of candidates can be tested.
+typedef enum TrialKernelKind {
+    /// Pick the best one the CPU supports.
+    TRIAL_KERNEL_AUTO,
+    /// `check_if_prime()` on each candidate in turn. Works for any candidate.
+    TRIAL_KERNEL_SCALAR,
+    /// 4 candidates per instruction, 16 at a time. Needs AVX2 and FMA.
+    TRIAL_KERNEL_AVX2,
+    /// 8 candidates per instruction, 32 at a time. Needs AVX-512F.
+    TRIAL_KERNEL_AVX512,
+} TrialKernelKind;
+
+/// A divisor as the vector kernels want it.
+typedef struct TrialDivisor {
+    double prime;
+    /// 1 / prime, rounded.
+    double reciprocal;
+} TrialDivisor;
+
+/// Tests blocks of candidates against a `BasePrimes` table.
+///
+/// When the kernel is no longer needed, call `trial_kernel_release()` on it to free the memory.
+/// None of the fields should be modified directly.
+typedef struct TrialKernel {
+    /// The kernel actually in use.
+    TrialKernelKind kind;
+    /// The table being divided by. Must outlive the kernel.
+    BasePrimes const* base;
+    /// The number of primes at the front of `base` that are skipped. See `check_if_prime()`.
+    size_t skip;
+    /// TrialDivisor. `divisors[i]` goes with `base->primes[i]`. Empty for the scalar kernel.
+    CaveVec divisors;
+    /// The index of the first divisor the survivors are tested against.
+    size_t split;
+    /// Survivors of the first divisors, waiting on a full block.
+    uint64_t pending[TRIAL_KERNEL_BLOCK_SIZE];
+    size_t pending_len;
+} TrialKernel;
+
+
+/// \brief Whether the running CPU can use the kernel `kind`.
+///
+/// \param kind - The kernel to ask about. `TRIAL_KERNEL_AUTO` and `TRIAL_KERNEL_SCALAR` are always supported.
+/// \return true if `kind` can be used.
+bool trial_kernel_supported(TrialKernelKind kind);
+
+/// \brief The name of `kind`, such as "avx2".
+///
+/// \param kind - The kernel to name.
+/// \return A string literal.
+char const* trial_kernel_name(TrialKernelKind kind);
+
+/// \brief Initializes `k` to test candidates below `upperbound` against `base`.
+///
+/// \param k - The kernel to initialize.
+/// \param base - A base prime table made for `upperbound` or more. `base_primes_init_divisors()` must have been
+///               called on it, since the scalar kernel (and every kernel, for candidates it can't take) uses them.
+/// \param skip - The number of primes at the front of `base` the candidates are known not to be divisible by.
+/// \param upperbound - Every candidate will be less than this.
+/// \param kind - Which kernel to use. If it isn't supported, or `upperbound` is more than
+///               `TRIAL_KERNEL_MAX_VALUE`, the scalar kernel is used instead.
+/// \param[out] err - The error recording argument. If there is an error, it is written to this argument.
+///                   Otherwise `CAVE_NO_ERROR` is written to err.
+///                   Errors:
+///                   * CAVE_DATA_ERROR - If `k` or `base` is NULL.
+///                   * CAVE_INSUFFICIENT_MEMORY_ERROR - If malloc'ing does not succeed.
+/// \return `k` on success, NULL if there is an error.
+TrialKernel* trial_kernel_init(TrialKernel* k, BasePrimes const* base, size_t skip, uint64_t upperbound,
+                               TrialKernelKind kind, CaveError* err);
+
+/// \brief Frees the memory held by `k`.
+///
+/// \param k - The target kernel.
+void trial_kernel_release(TrialKernel* k);
+
+/// \brief Tests a block of candidates, and writes out the primes among them.
+///
+/// Candidates can be held back to be tested together with later ones, so the primes written out may be from
+/// earlier calls, and not all of this call's may be written yet. They always come out in the order the
+/// candidates went in. Call `trial_kernel_finish()` after the last candidates to get the rest.
+///
+/// \param k - The kernel to test with.
+/// \param candidates - The candidates, in ascending order, each greater than 1, greater than every earlier
+///                     candidate, and less than the kernel's bound.
+/// \param count - The number of candidates. At most `TRIAL_KERNEL_BLOCK_SIZE`.
+/// \param[out] primes - Where the primes are written. Must have room for `2 * TRIAL_KERNEL_BLOCK_SIZE`.
+/// \return The number of primes written.
+size_t trial_kernel_filter(TrialKernel* k, uint64_t const* candidates, size_t count, uint64_t* primes);
+
+/// \brief Tests any candidates `k` is still holding back, and writes out the primes among them.
+///
+/// \param k - The kernel to finish.
+/// \param[out] primes - Where the primes are written. Must have room for `TRIAL_KERNEL_BLOCK_SIZE`.
+/// \return The number of primes written.
+size_t trial_kernel_finish(TrialKernel* k, uint64_t* primes);
+
+#endif //FILTERED_PRIMES_TRIAL_KERNEL_H
@@ -0,0 +1,199 @@
+#ifndef FILTERED_PRIMES_TYPED_VEC_H
+#define FILTERED_PRIMES_TYPED_VEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cave-bedrock.h"
+#include "allocator.h"
+
+/// \file
+/// Vectors of one particular type, generated by a macro.
+///
+/// A `CaveVec` only knows its element size at runtime, so every access is `data + stride * index` through a
+/// `void*`, and a loop over one is a loop of calls and casts the compiler can't see through. The vectors made by
+/// `CAVE_TYPED_VEC()` hold a `T*` instead, so the element size is known at compile time, elements are read as
+/// plain `v.data[i]`, and a loop over them vectorizes like a loop over an array does. Every function is
+/// static inline, so there's no call either.
+///
+///     CAVE_TYPED_VEC(U64Vec, u64_vec, uint64_t)
+///
+/// declares a struct `U64Vec` and the functions `u64_vec_init()`, `u64_vec_init_with_allocator()`,
+/// `u64_vec_set_growth_factor()`, `u64_vec_release()`, `u64_vec_reserve()`, `u64_vec_shrink_to_fit()`,
+/// `u64_vec_push()`, `u64_vec_push_n()`, `u64_vec_at()`, `u64_vec_clear()` and `u64_vec_as_vec()`, which work
+/// like their `cave_vec` namesakes. The vector of uint64_t used all over this program is declared below as
+/// `U64Vec`.
+///
+/// A vector gets its memory from malloc, unless it's initialized with `prefix_init_with_allocator()`, in which
+/// case it gets it from the given `CaveAllocator` (see allocator.h) for as long as it lives. If the allocator
+/// can discard memory, clearing the vector discards all of it, so a vector from a `CavePageAllocator` hands
+/// its pages back when it's cleared, at the cost of faulting them in again when it's refilled.
+///
+/// A full vector grows by `CAVE_VEC_GROW_FACTOR`, unless `prefix_set_growth_factor()` says otherwise. A
+/// smaller factor wastes less memory on spare capacity but grows more often, which is a good trade when
+/// growing is cheap, as it is for a vector from a `CavePageAllocator`.
+
+/// \brief Declares a vector of `T` called `Name`, with functions starting with `prefix`.
+///
+/// The struct has the fields `T* data`, `size_t len`, `size_t capacity`, `CaveAllocator allocator` and
+/// `double growth_factor`.
+/// `data[0]` to `data[len - 1]` may be read and written directly, but the fields should not be modified directly.
+/// `prefix_as_vec()` gives a `CaveVec` view of the same memory, for the `cave_vec` functions that don't grow
+/// or free the vector.
+#define CAVE_TYPED_VEC(Name, prefix, T)                                                                            \
+    typedef struct Name {                                                                                          \
+        T* data;                                                                                                   \
+        size_t len;                                                                                                \
+        size_t capacity;                                                                                           \
+        CaveAllocator allocator;                                                                                   \
+        double growth_factor;                                                                                      \
+    } Name;                                                                                                        \
+                                                                                                                   \
+    /* initial_capacity of 0 means CAVE_VEC_DEFAULT_CAPACITY, as for cave_vec_init(). */                           \
+    static inline Name* prefix##_init_with_allocator(Name* v, CaveAllocator allocator, size_t initial_capacity,    \
+                                                    CaveError* err) {                                              \
+        if(v == NULL) {                                                                                            \
+            *err = CAVE_DATA_ERROR;                                                                                \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        size_t capacity = initial_capacity > 0 ? initial_capacity : CAVE_VEC_DEFAULT_CAPACITY;                     \
+        v->allocator = allocator;                                                                                  \
+        v->growth_factor = CAVE_VEC_GROW_FACTOR;                                                                   \
+        v->data = capacity <= SIZE_MAX / sizeof(T)                                                                 \
+                  ? (T*)allocator.alloc(allocator.context, capacity * sizeof(T)) : NULL;                           \
+        if(v->data == NULL) {                                                                                      \
+            *err = CAVE_INSUFFICIENT_MEMORY_ERROR;                                                                 \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        v->len = 0;                                                                                                \
+        v->capacity = capacity;                                                                                    \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline Name* prefix##_init(Name* v, size_t initial_capacity, CaveError* err) {                          \
+        return prefix##_init_with_allocator(v, cave_malloc_allocator, initial_capacity, err);                      \
+    }                                                                                                              \
+                                                                                                                   \
+    /* growth_factor must be more than 1. */                                                                       \
+    static inline Name* prefix##_set_growth_factor(Name* v, double growth_factor, CaveError* err) {                \
+        if(!(growth_factor > 1)) {                                                                                 \
+            *err = CAVE_DATA_ERROR;                                                                                \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        v->growth_factor = growth_factor;                                                                          \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline void prefix##_release(Name* v) {                                                                 \
+        if(v == NULL) {                                                                                            \
+            return;                                                                                                \
+        }                                                                                                          \
+        if(v->data != NULL) {                                                                                      \
+            v->allocator.free(v->allocator.context, v->data, v->capacity * sizeof(T));                             \
+        }                                                                                                          \
+        v->data = NULL;                                                                                            \
+        v->len = 0;                                                                                                \
+        v->capacity = 0;                                                                                           \
+    }                                                                                                              \
+                                                                                                                   \
+    /* never shrinks, unlike cave_vec_reserve(). */                                                                \
+    static inline Name* prefix##_reserve(Name* v, size_t capacity, CaveError* err) {                               \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        if(capacity <= v->capacity) {                                                                              \
+            return v;                                                                                              \
+        }                                                                                                          \
+        T* data = capacity <= SIZE_MAX / sizeof(T)                                                                 \
+                  ? (T*)v->allocator.realloc(v->allocator.context, v->data, v->capacity * sizeof(T),               \
+                                             capacity * sizeof(T))                                                 \
+                  : NULL;                                                                                          \
+        if(data == NULL) {                                                                                         \
+            *err = CAVE_INSUFFICIENT_MEMORY_ERROR;                                                                 \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        v->data = data;                                                                                            \
+        v->capacity = capacity;                                                                                    \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    /* the slow path of pushing. If growing geometrically fails, as it can with an arena or pool that has room */  \
+    /* for what's needed but not more, it grows by just what's needed instead. */                                  \
+    static inline Name* prefix##_grow_for(Name* v, size_t count, CaveError* err) {                                 \
+        if(count > SIZE_MAX - v->len) {                                                                            \
+            *err = CAVE_INSUFFICIENT_MEMORY_ERROR;                                                                 \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        double scaled = (double)v->capacity * v->growth_factor;                                                    \
+        size_t grown = scaled < (double)SIZE_MAX ? (size_t)scaled : SIZE_MAX;                                      \
+        size_t needed = v->len + count;                                                                            \
+        if(grown > needed && prefix##_reserve(v, grown, err) != NULL) {                                            \
+            return v;                                                                                              \
+        }                                                                                                          \
+        return prefix##_reserve(v, needed, err);                                                                   \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline Name* prefix##_push(Name* v, T element, CaveError* err) {                                        \
+        if(v->len == v->capacity && prefix##_grow_for(v, 1, err) == NULL) {                                        \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        v->data[v->len++] = element;                                                                               \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline Name* prefix##_push_n(Name* v, T const* elements, size_t count, CaveError* err) {                \
+        if(count > v->capacity - v->len && prefix##_grow_for(v, count, err) == NULL) {                             \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        if(count > 0) {                                                                                            \
+            memcpy(v->data + v->len, elements, count * sizeof(T));                                                 \
+        }                                                                                                          \
+        v->len += count;                                                                                           \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    /* checked. For unchecked access, use v->data[index]. */                                                       \
+    static inline T* prefix##_at(Name* v, size_t index, CaveError* err) {                                          \
+        if(index >= v->len) {                                                                                      \
+            *err = CAVE_INDEX_ERROR;                                                                               \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        return &v->data[index];                                                                                    \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline void prefix##_clear(Name* v) {                                                                   \
+        v->len = 0;                                                                                                \
+        if(v->allocator.discard != NULL && v->data != NULL) {                                                      \
+            v->allocator.discard(v->allocator.context, v->data, v->capacity * sizeof(T));                          \
+        }                                                                                                          \
+    }                                                                                                              \
+                                                                                                                   \
+    /* cuts the capacity down to the length (or 1, if it's empty). */                                              \
+    static inline Name* prefix##_shrink_to_fit(Name* v, CaveError* err) {                                          \
+        size_t capacity = v->len > 0 ? v->len : 1;                                                                 \
+        *err = CAVE_NO_ERROR;                                                                                      \
+        if(capacity >= v->capacity) {                                                                              \
+            return v;                                                                                              \
+        }                                                                                                          \
+        T* data = (T*)v->allocator.realloc(v->allocator.context, v->data, v->capacity * sizeof(T),                 \
+                                           capacity * sizeof(T));                                                  \
+        if(data == NULL) {                                                                                         \
+            *err = CAVE_INSUFFICIENT_MEMORY_ERROR;                                                                 \
+            return NULL;                                                                                           \
+        }                                                                                                          \
+        v->data = data;                                                                                            \
+        v->capacity = capacity;                                                                                    \
+        return v;                                                                                                  \
+    }                                                                                                              \
+                                                                                                                   \
+    static inline CaveVec prefix##_as_vec(Name* v) {                                                               \
+        return (CaveVec){.data = v->data, .stride = sizeof(T), .capacity = v->capacity, .len = v->len};            \
+    }
+
+CAVE_TYPED_VEC(U64Vec, u64_vec, uint64_t)
+
+#endif //FILTERED_PRIMES_TYPED_VEC_H
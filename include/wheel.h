@@ -0,0 +1,85 @@
+#ifndef FILTERED_PRIMES_WHEEL_H
+#define FILTERED_PRIMES_WHEEL_H
+
+#include <stdint.h>
+
+/// \file
+/// Wheel factorization.
+///
+/// Every prime other than the handful the wheel is built from is coprime to the wheel's modulus,
+/// so the only numbers worth looking at are the ones whose remainder mod the modulus is coprime to it.
+/// For the mod 30 wheel that's 8 numbers out of every 30, and for the mod 210 wheel it's 48 out of
+/// every 210, which is about 77% fewer candidates than checking every integer.
+
+/// The wheels there are to choose from. The value of each is its modulus.
+typedef enum WheelKind {
+    /// Built from 2, 3 and 5.
+    WHEEL_30 = 30,
+    /// Built from 2, 3, 5 and 7.
+    WHEEL_210 = 210,
+} WheelKind;
+
+/// The most residues any wheel has (the mod 210 wheel's 48).
+#define WHEEL_MAX_RESIDUES (48)
+/// The largest modulus of any wheel.
+#define WHEEL_MAX_MODULUS (210)
+
+/// The tables describing one turn of a wheel. Fill one in with `wheel_init()`, and don't modify it after.
+typedef struct Wheel {
+    uint32_t modulus;
+    /// The primes the wheel is built from, ascending. These are the only primes that are not candidates.
+    uint32_t primes[4];
+    uint32_t prime_count;
+    /// The residues mod `modulus` that are coprime to it, ascending. The first is always 1.
+    uint8_t residues[WHEEL_MAX_RESIDUES];
+    /// `gaps[i]` is the distance from `residues[i]` to the next residue, wrapping around into the next turn.
+    uint8_t gaps[WHEEL_MAX_RESIDUES];
+    uint32_t residue_count;
+    /// For each `r` less than `modulus`, the index of the first residue greater than or equal to `r`,
+    /// or `residue_count` if there isn't one.
+    uint8_t next_residue[WHEEL_MAX_MODULUS];
+} Wheel;
+
+/// Walks the candidates of a wheel, in ascending order.
+///
+/// Once the candidates would go past `UINT64_MAX`, `value` sticks at `UINT64_MAX`, which is never
+/// a candidate (it's divisible by 3 and 5), so loops bounded by an upperbound always terminate.
+typedef struct WheelIter {
+    Wheel const* wheel;
+    /// The current candidate.
+    uint64_t value;
+    /// The index into `wheel->residues` of `value % wheel->modulus`.
+    uint32_t index;
+} WheelIter;
+
+
+/// \brief Fills in `w` with the tables for the wheel `kind`.
+///
+/// \param w - The wheel to fill in.
+/// \param kind - Which wheel to build.
+/// \return `w`
+Wheel* wheel_init(Wheel* w, WheelKind kind);
+
+/// \brief Points `it` at the first candidate of `w` greater than or equal to `start`.
+///
+/// \param it - The iterator to initialize.
+/// \param w - The wheel to walk. Must outlive `it`.
+/// \param start - Where to start from.
+/// \return `it`
+WheelIter* wheel_iter_init(WheelIter* it, Wheel const* w, uint64_t start);
+
+/// \brief Moves `it` on to the next candidate.
+///
+/// \param it - The target iterator.
+/// \return The new candidate.
+static inline uint64_t wheel_iter_next(WheelIter* it) {
+    uint8_t gap = it->wheel->gaps[it->index];
+    it->value = it->value <= UINT64_MAX - gap ? it->value + gap : UINT64_MAX;
+    it->index++;
+    if(it->index == it->wheel->residue_count) {
+        it->index = 0;
+    }
+    return it->value;
+}
+
+#endif //FILTERED_PRIMES_WHEEL_H
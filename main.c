@@ -1,95 +1,333 @@
 #include <stdio.h>
 #include "include/cave-bedrock.h"
+#include "include/sieve.h"
+#include "include/parallel-sieve.h"
+#include "include/growth-filter.h"
+#include "include/direct-filter.h"
+#include "include/prime-count.h"
+#include "include/pipeline.h"
+#include "include/prime-table.h"
+#include "include/text-writer.h"
+#include "include/c-header.h"
+#include "include/trial-division.h"
+#include "include/checkpoint.h"
+#include "include/progress.h"
+#include "include/cli.h"
 #include <inttypes.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 //if the system is 64 bit, we provide this program. Otherwise, we provide an empty file
 //(which will be an error) as this code assumes a size_t is 64bit.
 #if UINTPTR_MAX == UINT64_MAX
 
-//num is the number we are checking to see if it is prime.
-//prior_primes is a list of every number less than num that is prime.
-bool check_if_prime(uint64_t num, CaveVec* prior_primes) {
-    for(size_t i = 0; i < prior_primes->len; i++) {
-        uint64_t prime_i = *(uint64_t*)cave_vec_at_unchecked(prior_primes, i);
-        //never need to check past sqrt(num). However, casting num to floating point and calling
-        //sqrt() on it introduces floating point error. I don't know enough about floating point error to
-        //calculate when the error would be off by 1 or more, but if any prime is missed, then the whole thing
-        //will start getting filled up with non-prime numbers. So I check this way instead. I'm guessing
-        //it's a similar speed.
-        if(prime_i * prime_i > num) {
-            return true;
-        }
-        if(num % prime_i == 0) {
-            return false;
-        }
+void check_error(CaveError err) {
+    if(err != CAVE_NO_ERROR) {
+        const char* err_str = cave_error_string(err);
+        printf("Error: %s", err_str);
+        exit(-1);
     }
-    return true;
 }
 
+//where every prime found goes when --all-primes is given, in one format or the other.
+typedef struct AllPrimesSink {
+    CliFormat format;
+    PrimeTableWriter table;
+    FILE* file;
+    TextWriter text;
+} AllPrimesSink;
 
+void all_primes_sink_open(AllPrimesSink* sink, CliOptions const* options, CaveError* err) {
+    sink->format = options->format;
+    if(sink->format == CLI_FORMAT_BINARY) {
+        prime_table_writer_open(&sink->table, options->all_primes_out, options->bound, 0,
+                                prime_table_width_for(options->bound), err);
+        return;
+    }
+    sink->file = fopen(options->all_primes_out, "w");
+    if(sink->file == NULL) {
+        *err = CAVE_FILE_ERROR;
+        return;
+    }
+    if(text_writer_init(&sink->text, fileno(sink->file), err) == NULL) {
+        fclose(sink->file);
+    }
+}
 
-void fprint_vec_of_uint64(CaveVec* v, FILE * stream) {
-    for(size_t i = 0; i < v->len; i++) {
-        uint64_t element = *(uint64_t*)cave_vec_at_unchecked(v, i);
-        fprintf(stream, "%" PRIu64 " , ", element);
+//picks the output back up as it was at checkpoint c, cutting off whatever was written after.
+void all_primes_sink_resume(AllPrimesSink* sink, CliOptions const* options, Checkpoint const* c, CaveError* err) {
+    sink->format = options->format;
+    if(sink->format == CLI_FORMAT_BINARY) {
+        PrimeTableHeader header = {
+            .version = PRIME_TABLE_VERSION,
+            .element_width = prime_table_width_for(options->bound),
+            .bound = options->bound,
+            .count = c->output_length,
+            .growth = 0,
+            .checksum = c->output_checksum,
+        };
+        prime_table_writer_resume(&sink->table, options->all_primes_out, &header, c->output_last, err);
+        return;
+    }
+    sink->file = fopen(options->all_primes_out, "r+");
+    if(sink->file == NULL) {
+        *err = CAVE_FILE_ERROR;
+        return;
+    }
+    int fd = fileno(sink->file);
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (uint64_t)st.st_size < c->output_length) {
+        fclose(sink->file);
+        *err = CAVE_DATA_ERROR;
+        return;
+    }
+    if(ftruncate(fd, (off_t)c->output_length) != 0 || lseek(fd, 0, SEEK_END) < 0) {
+        fclose(sink->file);
+        *err = CAVE_FILE_ERROR;
+        return;
+    }
+    if(text_writer_init(&sink->text, fd, err) == NULL) {
+        fclose(sink->file);
     }
-    fprintf(stream, "\n");
 }
 
-void check_error(CaveError err) {
-    if(err != CAVE_NO_ERROR) {
-        const char* err_str = cave_error_string(err);
-        printf("Error: %s", err_str);
-        exit(-1);
+//gets everything written so far onto the disk, and records how much that is in c.
+void all_primes_sink_sync(AllPrimesSink* sink, Checkpoint* c, CaveError* err) {
+    if(sink->format == CLI_FORMAT_BINARY) {
+        if(prime_table_writer_flush(&sink->table, err) != NULL) {
+            c->output = CHECKPOINT_OUTPUT_TABLE;
+            c->output_length = sink->table.header.count;
+            c->output_checksum = sink->table.header.checksum;
+            c->output_last = sink->table.last;
+        }
+        return;
+    }
+    if(text_writer_flush(&sink->text, err) == NULL) {
+        return;
     }
+    off_t length = lseek(sink->text.fd, 0, SEEK_CUR);
+    if(length < 0 || fsync(sink->text.fd) != 0) {
+        *err = CAVE_FILE_ERROR;
+        return;
+    }
+    c->output = CHECKPOINT_OUTPUT_TEXT;
+    c->output_length = (uint64_t)length;
 }
 
-int main(int arc, char * argv[] ) {
-    CaveError err = CAVE_NO_ERROR;
-    CaveVec primes;
-    cave_vec_init(&primes, sizeof(uint64_t), 1000000, &err);
-    check_error(err);
+PRIME_BATCH_CLOSURE all_primes_sink_closure(AllPrimesSink* sink, void** closure_data) {
+    if(sink->format == CLI_FORMAT_BINARY) {
+        *closure_data = &sink->table;
+        return prime_table_writer_consume;
+    }
+    *closure_data = &sink->text;
+    return text_writer_consume;
+}
 
-    uint64_t two_literal = 2;
-    cave_vec_push(&primes, &two_literal, &err);
+//finishes the output. If err is already set, the output is abandoned instead, and err is left alone.
+void all_primes_sink_close(AllPrimesSink* sink, CaveError* err) {
+    CaveError close_err = CAVE_NO_ERROR;
+    if(sink->format == CLI_FORMAT_BINARY) {
+        if(*err != CAVE_NO_ERROR) {
+            prime_table_writer_abandon(&sink->table);
+        } else {
+            prime_table_writer_close(&sink->table, &close_err);
+        }
+    } else {
+        if(*err == CAVE_NO_ERROR) {
+            text_writer_str(&sink->text, "\n", &close_err);
+        }
+        CaveError release_err;
+        if(!text_writer_release(&sink->text, &release_err) && close_err == CAVE_NO_ERROR) {
+            close_err = release_err;
+        }
+        if(fclose(sink->file) != 0 && close_err == CAVE_NO_ERROR) {
+            close_err = CAVE_FILE_ERROR;
+        }
+    }
+    if(*err == CAVE_NO_ERROR) {
+        *err = close_err;
+    }
+}
 
-//the number of bytes in 12 GB. Chosen because it's a pretty large number that I can also
-//check all numbers below in less than a day.
-    uint64_t upperbound = (uint64_t) 12884901888;
+//what a checkpoint is taken from.
+typedef struct CheckpointSource {
+    CliOptions const* options;
+    PrimePipeline* pipeline;
+    //NULL if there's no --all-primes.
+    AllPrimesSink* sink;
+} CheckpointSource;
 
-    for(uint64_t i = 3; i < upperbound; i++) {
-        bool i_is_prime = check_if_prime((size_t)i, &primes);
-        if(i_is_prime) {
-            cave_vec_push(&primes, &i, &err);
-            check_error(err);
-        }
+void save_checkpoint(uint64_t position, void* closure_data, CaveError* err) {
+    CheckpointSource* source = closure_data;
+    Checkpoint c = {
+        .bound = source->options->bound,
+        .growth = source->options->growth,
+        .position = position,
+        .count = source->pipeline->count,
+        .filtered = source->pipeline->filtered,
+        .output = CHECKPOINT_OUTPUT_NONE,
+    };
+    *err = CAVE_NO_ERROR;
+    if(source->sink != NULL) {
+        all_primes_sink_sync(source->sink, &c, err);
+    }
+    if(*err == CAVE_NO_ERROR) {
+        checkpoint_save(&c, source->options->checkpoint, err);
+    }
+}
+
+//whether c was saved by a run with the same options, so carrying on from it gives the same result.
+bool checkpoint_matches(Checkpoint const* c, CliOptions const* options) {
+    CheckpointOutput output = options->all_primes_out == NULL ? CHECKPOINT_OUTPUT_NONE
+                            : options->format == CLI_FORMAT_BINARY ? CHECKPOINT_OUTPUT_TABLE
+                            : CHECKPOINT_OUTPUT_TEXT;
+    if(c->bound != options->bound || c->growth != options->growth) {
+        printf("Error: the checkpoint is for --bound %" PRIu64 " --growth %.17g\n", c->bound, c->growth);
+        return false;
+    }
+    if(c->output != output) {
+        printf("Error: the checkpoint was saved with a different --all-primes and --format\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int arc, char * argv[] ) {
+    //see cli.h, or run with --help, for the options.
+    CliOptions options;
+    cli_options_default(&options);
+    if(!cli_parse(&options, arc, argv, stdout)) {
+        exit(-1);
+    }
+    if(options.help) {
+        cli_print_usage(stdout, argv[0]);
+        return 0;
     }
+    uint64_t upperbound = options.bound;
+    double growth = options.growth;
 
+    CaveError err = CAVE_NO_ERROR;
 
-    printf("number of primes between 1 and %" PRIu64 " is %" PRIu64 ".\n", upperbound, (uint64_t)primes.len);
+    if(options.engine == CLI_ENGINE_COUNT) {
+        uint64_t count = prime_count_below(upperbound, &err);
+        check_error(err);
+        printf("number of primes between 1 and %" PRIu64 " is %" PRIu64 ".\n", upperbound, count);
+        return 0;
+    }
 
     CaveVec filtered_primes;
     cave_vec_init(&filtered_primes, sizeof(uint64_t), 0, &err);
     check_error(err);
-    cave_vec_push(&filtered_primes,&two_literal, &err);
-    check_error(err);
 
-    uint64_t prev_prime = 2;
-    for(size_t i = 0; i < primes.len; i++) {
-        uint64_t curr_prime = *(uint64_t*) cave_vec_at_unchecked(&primes, i);
-        if((double)curr_prime > 1.5 * (double)prev_prime) {
-            cave_vec_push(&filtered_primes, &curr_prime, &err);
+    if(options.engine == CLI_ENGINE_DIRECT) {
+        direct_filtered_primes_below(&filtered_primes, upperbound, growth, &err);
+        check_error(err);
+    } else {
+        //the primes stream straight from the engine through the growth filter, so the full list
+        //is never held in memory (see pipeline.h). If they're being written out too, that happens as they go.
+        //with --resume, everything below the checkpoint's position is already done (see checkpoint.h).
+        Checkpoint checkpoint = {.position = 0};
+        if(options.resume) {
+            checkpoint_load(&checkpoint, options.checkpoint, &filtered_primes, &err);
             check_error(err);
-            prev_prime = curr_prime;
+            if(!checkpoint_matches(&checkpoint, &options)) {
+                exit(-1);
+            }
         }
+
+        AllPrimesSink sink;
+        PRIME_BATCH_CLOSURE next = NULL;
+        void* next_data = NULL;
+        if(options.all_primes_out != NULL) {
+            if(options.resume) {
+                all_primes_sink_resume(&sink, &options, &checkpoint, &err);
+            } else {
+                all_primes_sink_open(&sink, &options, &err);
+            }
+            check_error(err);
+            next = all_primes_sink_closure(&sink, &next_data);
+        }
+        PrimePipeline pipeline;
+        if(options.resume) {
+            prime_pipeline_resume(&pipeline, &filtered_primes, growth, checkpoint.count, next, next_data, &err);
+        } else {
+            prime_pipeline_init(&pipeline, &filtered_primes, growth, next, next_data, &err);
+        }
+        check_error(err);
+
+        //the engine feeds the pipeline, through a stage that reports progress with --progress, and through
+        //one that saves checkpoints with --checkpoint.
+        PRIME_BATCH_CLOSURE fn = prime_pipeline_consume;
+        void* fn_data = &pipeline;
+        ProgressReporter progress;
+        if(options.progress) {
+            progress_reporter_start(&progress, stderr, upperbound, options.progress_interval,
+                                    checkpoint.position, pipeline.count, fn, fn_data, &err);
+            check_error(err);
+            fn = progress_reporter_consume;
+            fn_data = &progress;
+        }
+        CheckpointSource source = {&options, &pipeline, options.all_primes_out != NULL ? &sink : NULL};
+        CheckpointStage stage;
+        if(options.checkpoint != NULL) {
+            checkpoint_stage_init(&stage, checkpoint.position, options.checkpoint_interval,
+                                  fn, fn_data, save_checkpoint, &source);
+            fn = checkpoint_stage_consume;
+            fn_data = &stage;
+        }
+
+        uint64_t start = checkpoint.position;
+        switch(options.engine) {
+            case CLI_ENGINE_SIEVE:
+                sieve_foreach_batch_from(start, upperbound, options.segment_bytes, options.wheel, fn, fn_data, &err);
+                break;
+            case CLI_ENGINE_TRIAL:
+                trial_division_foreach_batch_from(start, upperbound, options.wheel, fn, fn_data, &err);
+                break;
+            default:
+                //a thread_count of 0 uses one worker per online processor.
+                parallel_sieve_foreach_batch_from(start, upperbound, options.segment_bytes, options.wheel,
+                                                  options.threads, fn, fn_data, &err);
+                break;
+        }
+        if(options.progress) {
+            progress_reporter_stop(&progress, upperbound);
+        }
+        if(options.all_primes_out != NULL) {
+            all_primes_sink_close(&sink, &err);
+        }
+        check_error(err);
+        //the run is complete, so there's nothing left to resume.
+        if(options.checkpoint != NULL) {
+            remove(options.checkpoint);
+        }
+
+        printf("number of primes between 1 and %" PRIu64 " is %" PRIu64 ".\n", upperbound, pipeline.count);
     }
 
-    fprint_vec_of_uint64(&filtered_primes, stdout);
+    fprint_vec_of_uint64(&filtered_primes, stdout, &err);
+    check_error(err);
 
-    FILE* out_file = fopen("out.txt", "w");
-    fprint_vec_of_uint64(&filtered_primes, out_file);
-    fclose(out_file);
+    switch(options.format) {
+        case CLI_FORMAT_BINARY:
+            prime_table_write(options.out, &filtered_primes, upperbound, growth, &err);
+            break;
+        case CLI_FORMAT_C_HEADER:
+            c_header_write(options.out, &filtered_primes, upperbound, growth, C_HEADER_DEFAULT_PREFIX, &err);
+            break;
+        default: {
+            FILE* out_file = fopen(options.out, "w");
+            if(out_file == NULL) {
+                err = CAVE_FILE_ERROR;
+                break;
+            }
+            fprint_vec_of_uint64(&filtered_primes, out_file, &err);
+            fclose(out_file);
+            break;
+        }
+    }
+    check_error(err);
 
     return 0;
 }
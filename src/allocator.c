@@ -0,0 +1,196 @@
+#include "include/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static void* malloc_alloc(void* context, size_t bytes) {
+    (void)context;
+    return malloc(bytes);
+}
+
+static void* malloc_realloc(void* context, void* ptr, size_t old_bytes, size_t new_bytes) {
+    (void)context;
+    (void)old_bytes;
+    return realloc(ptr, new_bytes);
+}
+
+static void malloc_free(void* context, void* ptr, size_t bytes) {
+    (void)context;
+    (void)bytes;
+    free(ptr);
+}
+
+CaveAllocator const cave_malloc_allocator = {
+        .alloc = malloc_alloc, .realloc = malloc_realloc, .free = malloc_free, .context = NULL};
+
+//rounds up to a multiple of CAVE_ALLOCATOR_ALIGNMENT, or gives 0 if that would overflow.
+static size_t align_up(size_t bytes) {
+    size_t mask = CAVE_ALLOCATOR_ALIGNMENT - 1;
+    return bytes <= SIZE_MAX - mask ? (bytes + mask) & ~mask : 0;
+}
+
+//the arena
+
+CaveArena* cave_arena_init(CaveArena* a, size_t capacity, CaveError* err) {
+    if(a == NULL || capacity == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    //aligned_alloc wants the size to be a multiple of the alignment.
+    size_t bytes = align_up(capacity);
+    a->base = bytes != 0 ? aligned_alloc(CAVE_ALLOCATOR_ALIGNMENT, bytes) : NULL;
+    if(a->base == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    a->capacity = bytes;
+    a->used = 0;
+    a->last = 0;
+    *err = CAVE_NO_ERROR;
+    return a;
+}
+
+void* cave_arena_alloc(CaveArena* a, size_t bytes) {
+    size_t size = align_up(bytes > 0 ? bytes : 1);
+    if(size == 0 || size > a->capacity - a->used) {
+        return NULL;
+    }
+    a->last = a->used;
+    a->used += size;
+    return a->base + a->last;
+}
+
+void cave_arena_reset(CaveArena* a) {
+    a->used = 0;
+    a->last = 0;
+}
+
+void cave_arena_release(CaveArena* a) {
+    if(a == NULL) {
+        return;
+    }
+    free(a->base);
+    a->base = NULL;
+    a->capacity = 0;
+    a->used = 0;
+    a->last = 0;
+}
+
+static void* arena_alloc(void* context, size_t bytes) {
+    return cave_arena_alloc(context, bytes);
+}
+
+static void* arena_realloc(void* context, void* ptr, size_t old_bytes, size_t new_bytes) {
+    CaveArena* a = context;
+    if(ptr == NULL) {
+        return cave_arena_alloc(a, new_bytes);
+    }
+    //the most recent allocation has nothing after it, so it can just be extended.
+    if((unsigned char*)ptr == a->base + a->last) {
+        size_t size = align_up(new_bytes > 0 ? new_bytes : 1);
+        if(size == 0 || size > a->capacity - a->last) {
+            return NULL;
+        }
+        a->used = a->last + size;
+        return ptr;
+    }
+    if(new_bytes <= old_bytes) {
+        return ptr;
+    }
+    void* moved = cave_arena_alloc(a, new_bytes);
+    if(moved != NULL) {
+        memcpy(moved, ptr, old_bytes);
+    }
+    return moved;
+}
+
+static void arena_free(void* context, void* ptr, size_t bytes) {
+    (void)bytes;
+    CaveArena* a = context;
+    //only the most recent allocation can be given back before a reset.
+    if(ptr != NULL && (unsigned char*)ptr == a->base + a->last) {
+        a->used = a->last;
+    }
+}
+
+CaveAllocator cave_arena_allocator(CaveArena* a) {
+    return (CaveAllocator){.alloc = arena_alloc, .realloc = arena_realloc, .free = arena_free, .context = a};
+}
+
+//the pool
+
+CavePool* cave_pool_init(CavePool* p, size_t block_size, size_t block_count, CaveError* err) {
+    if(p == NULL || block_size == 0 || block_count == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    //a free block holds the free list's next pointer, so it has to have room for one.
+    size_t size = align_up(block_size > sizeof(void*) ? block_size : sizeof(void*));
+    p->blocks = size != 0 && block_count <= SIZE_MAX / size
+                ? aligned_alloc(CAVE_ALLOCATOR_ALIGNMENT, size * block_count) : NULL;
+    if(p->blocks == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    p->block_size = size;
+    p->block_count = block_count;
+    //threaded back to front, so the blocks are handed out in address order.
+    p->free_list = NULL;
+    for(size_t i = block_count; i > 0; i--) {
+        void* block = p->blocks + (i - 1) * size;
+        memcpy(block, &p->free_list, sizeof(void*));
+        p->free_list = block;
+    }
+    *err = CAVE_NO_ERROR;
+    return p;
+}
+
+void* cave_pool_alloc(CavePool* p) {
+    void* block = p->free_list;
+    if(block != NULL) {
+        memcpy(&p->free_list, block, sizeof(void*));
+    }
+    return block;
+}
+
+void cave_pool_free(CavePool* p, void* block) {
+    if(block == NULL) {
+        return;
+    }
+    memcpy(block, &p->free_list, sizeof(void*));
+    p->free_list = block;
+}
+
+void cave_pool_release(CavePool* p) {
+    if(p == NULL) {
+        return;
+    }
+    free(p->blocks);
+    p->blocks = NULL;
+    p->block_count = 0;
+    p->free_list = NULL;
+}
+
+static void* pool_alloc(void* context, size_t bytes) {
+    CavePool* p = context;
+    return bytes <= p->block_size ? cave_pool_alloc(p) : NULL;
+}
+
+static void* pool_realloc(void* context, void* ptr, size_t old_bytes, size_t new_bytes) {
+    (void)old_bytes;
+    CavePool* p = context;
+    if(new_bytes > p->block_size) {
+        return NULL;
+    }
+    //every block is already as big as any allocation can be.
+    return ptr != NULL ? ptr : cave_pool_alloc(p);
+}
+
+static void pool_free(void* context, void* ptr, size_t bytes) {
+    (void)bytes;
+    cave_pool_free(context, ptr);
+}
+
+CaveAllocator cave_pool_allocator(CavePool* p) {
+    return (CaveAllocator){.alloc = pool_alloc, .realloc = pool_realloc, .free = pool_free, .context = p};
+}
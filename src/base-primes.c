@@ -0,0 +1,127 @@
+#include "include/base-primes.h"
+#include <stdlib.h>
+#include <string.h>
+
+//the odd numbers per segment when sieving out the table. Small enough to stay in L1 cache.
+#define BASE_PRIMES_SEGMENT_BYTES (1 << 15)
+
+BasePrimes* base_primes_init(BasePrimes* b, uint64_t upperbound, CaveError* err) {
+    if(b == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    uint64_t limit = upperbound < 2 ? 0 : isqrt_u64(upperbound - 1);
+    b->limit = (uint32_t)limit;
+    if(cave_vec_init(&b->divisors, sizeof(BaseDivisor), 0, err) == NULL) {
+        return NULL;
+    }
+
+    //roughly limit / ln(limit) primes, so reserving limit / 8 (plus some) is rarely far off.
+    if(cave_vec_init(&b->primes, sizeof(uint32_t), (size_t)(limit / 8 + 64), err) == NULL) {
+        cave_vec_release(&b->divisors);
+        return NULL;
+    }
+    if(limit < 2) {
+        return b;
+    }
+    uint32_t two = 2;
+    if(cave_vec_push(&b->primes, &two, err) == NULL) {
+        base_primes_release(b);
+        return NULL;
+    }
+
+    //the table can run up to 2^32, so it's sieved a segment at a time like everything else. The primes
+    //that cross off within it only go up to 2^16, and each one is pushed before it's needed.
+    uint8_t* segment = malloc(BASE_PRIMES_SEGMENT_BYTES);
+    if(segment == NULL) {
+        base_primes_release(b);
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    //byte j of the segment starting at low is the number low + 2j + 1.
+    for(uint64_t low = 0; low <= limit; low += 2 * BASE_PRIMES_SEGMENT_BYTES) {
+        uint64_t last = low + 2 * BASE_PRIMES_SEGMENT_BYTES - 1 < limit ? low + 2 * BASE_PRIMES_SEGMENT_BYTES - 1 : limit;
+        size_t n = (size_t)((last - low + 1) / 2);
+        memset(segment, 1, n);
+        if(low == 0) {
+            //1 is not prime.
+            segment[0] = 0;
+        }
+
+        uint32_t const* primes = b->primes.data;
+        //skip 2, since the segment only has odd numbers.
+        for(size_t i = 1; i < b->primes.len && (uint64_t)primes[i] * primes[i] <= last; i++) {
+            uint64_t p = primes[i];
+            uint64_t first = p * p;
+            if(first < low) {
+                first = low + (p - low % p) % p;
+                if(first % 2 == 0) {
+                    first += p;
+                }
+            }
+            for(uint64_t j = (first - low) / 2; j < n; j += p) {
+                segment[j] = 0;
+            }
+        }
+        //primes found in this segment can cross off later in it, which is why the first segment (which
+        //holds all the primes below 2^16 that cross off anywhere) is walked and pushed as it goes.
+        for(size_t j = 0; j < n; j++) {
+            if(!segment[j]) {
+                continue;
+            }
+            uint32_t p = (uint32_t)(low + 2 * j + 1);
+            if(cave_vec_push(&b->primes, &p, err) == NULL) {
+                free(segment);
+                base_primes_release(b);
+                return NULL;
+            }
+            if(low == 0) {
+                for(uint64_t m = (uint64_t)p * p; m <= last; m += 2 * (uint64_t)p) {
+                    segment[(m - low) / 2] = 0;
+                }
+            }
+        }
+    }
+    free(segment);
+
+    *err = CAVE_NO_ERROR;
+    return b;
+}
+
+BasePrimes* base_primes_init_divisors(BasePrimes* b, CaveError* err) {
+    if(b == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(cave_vec_reserve(&b->divisors, b->primes.len > 0 ? b->primes.len : 1, err) == NULL) {
+        return NULL;
+    }
+    cave_vec_clear(&b->divisors, err);
+
+    uint32_t const* primes = b->primes.data;
+    for(size_t i = 0; i < b->primes.len; i++) {
+        uint64_t p = primes[i];
+        BaseDivisor d = {0, 0};
+        if(p % 2 == 1) {
+            //Newton's method for inverses mod 2^64. p is its own inverse mod 8, good to 3 bits,
+            //and every step doubles the number of correct bits: 3, 6, 12, 24, 48, 96.
+            uint64_t inverse = p;
+            for(int step = 0; step < 5; step++) {
+                inverse *= 2 - p * inverse;
+            }
+            d.inverse = inverse;
+            d.limit = UINT64_MAX / p;
+        }
+        cave_vec_push(&b->divisors, &d, err);
+    }
+    *err = CAVE_NO_ERROR;
+    return b;
+}
+
+void base_primes_release(BasePrimes* b) {
+    if(b == NULL) {
+        return;
+    }
+    cave_vec_release(&b->primes);
+    cave_vec_release(&b->divisors);
+}
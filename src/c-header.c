@@ -0,0 +1,81 @@
+#include "include/c-header.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+static bool is_identifier(char const* s) {
+    if(s[0] == '\0' || isdigit((unsigned char)s[0])) {
+        return false;
+    }
+    for(; *s != '\0'; s++) {
+        if(!isalnum((unsigned char)*s) && *s != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+//prints prefix in upper case.
+static void fprint_upper(FILE* f, char const* prefix) {
+    for(; *prefix != '\0'; prefix++) {
+        fputc(toupper((unsigned char)*prefix), f);
+    }
+}
+
+static bool fprint_header(FILE* f, CaveVec const* values, uint64_t bound, double growth, char const* prefix) {
+    uint64_t const* v = values->data;
+    fprintf(f, "// Generated by filtered-primes. Do not edit.\n");
+    fprintf(f, "// Starting from 2, every prime below %" PRIu64 " that is more than %.17g times the last one kept.\n",
+            bound, growth);
+    fprintf(f, "#ifndef ");
+    fprint_upper(f, prefix);
+    fprintf(f, "_TABLE_H\n#define ");
+    fprint_upper(f, prefix);
+    fprintf(f, "_TABLE_H\n\n#include <stdint.h>\n\n#define ");
+    fprint_upper(f, prefix);
+    fprintf(f, "_BOUND UINT64_C(%" PRIu64 ")\n#define ", bound);
+    fprint_upper(f, prefix);
+    //17 significant digits is enough for any double to read back as exactly the same double.
+    fprintf(f, "_GROWTH (%.17g)\n#define ", growth);
+    fprint_upper(f, prefix);
+    fprintf(f, "_COUNT (%zu)\n\nstatic const uint64_t %s[", values->len, prefix);
+    fprint_upper(f, prefix);
+    fprintf(f, "_COUNT] = {\n");
+    for(size_t i = 0; i < values->len; i++) {
+        fprintf(f, "    UINT64_C(%" PRIu64 "),\n", v[i]);
+    }
+    fprintf(f, "};\n\n#endif\n");
+    return !ferror(f);
+}
+
+bool c_header_write(char const* path, CaveVec const* values, uint64_t bound, double growth, char const* prefix,
+                    CaveError* err) {
+    if(path == NULL || values == NULL || prefix == NULL || values->len == 0 || !is_identifier(prefix)) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    size_t path_len = strlen(path);
+    char* tmp_path = malloc(path_len + sizeof(".tmp"));
+    if(tmp_path == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return false;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE* f = fopen(tmp_path, "w");
+    bool ok = f != NULL;
+    if(ok) {
+        ok = fprint_header(f, values, bound, growth, prefix);
+        ok = fclose(f) == 0 && ok;
+    }
+    ok = ok && rename(tmp_path, path) == 0;
+    if(!ok) {
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    *err = ok ? CAVE_NO_ERROR : CAVE_FILE_ERROR;
+    return ok;
+}
@@ -0,0 +1,43 @@
+#include "include/cave-bedrock.h"
+#include <string.h>
+#include <stdint.h>
+
+//the bulk vector operations declared in cave-bedrock.h that Cave itself doesn't have yet. They're written
+//against the public API only, so they work with any build of the library.
+
+CaveVec* cave_vec_push_n(CaveVec* v, void const* elements, size_t count, CaveError* err) {
+    if(v == NULL || (elements == NULL && count != 0)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    if(count == 0) {
+        return v;
+    }
+    if(count > SIZE_MAX - v->len) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    size_t needed = v->len + count;
+    if(needed > v->capacity) {
+        //grown geometrically like cave_vec_push() does, or a vector filled a batch at a time would be
+        //reallocated on every batch.
+        size_t grown = v->capacity <= SIZE_MAX / CAVE_VEC_GROW_FACTOR ? v->capacity * CAVE_VEC_GROW_FACTOR
+                                                                      : SIZE_MAX;
+        if(cave_vec_reserve(v, grown > needed ? grown : needed, err) == NULL) {
+            return NULL;
+        }
+    }
+    memcpy((unsigned char*)v->data + v->len * v->stride, elements, count * v->stride);
+    //the same bookkeeping cave_vec_push() does, once for the lot.
+    v->len = needed;
+    return v;
+}
+
+CaveVec* cave_vec_append(CaveVec* dest, CaveVec const* src, CaveError* err) {
+    if(dest == NULL || src == NULL || src == dest || src->stride != dest->stride) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    return cave_vec_push_n(dest, src->data, src->len, err);
+}
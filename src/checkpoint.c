@@ -0,0 +1,169 @@
+#include "include/checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+static char const* const output_names[] = {"none", "text", "table"};
+
+static bool fprint_checkpoint(FILE* f, Checkpoint const* c) {
+    uint64_t const* filtered = c->filtered->data;
+    fprintf(f, "filtered-primes checkpoint %d\n", CHECKPOINT_VERSION);
+    fprintf(f, "bound %" PRIu64 "\n", c->bound);
+    //as a hex float, so it reads back exactly.
+    fprintf(f, "growth %a\n", c->growth);
+    fprintf(f, "position %" PRIu64 "\n", c->position);
+    fprintf(f, "count %" PRIu64 "\n", c->count);
+    fprintf(f, "output %s", output_names[c->output]);
+    if(c->output == CHECKPOINT_OUTPUT_TEXT) {
+        fprintf(f, " %" PRIu64, c->output_length);
+    } else if(c->output == CHECKPOINT_OUTPUT_TABLE) {
+        fprintf(f, " %" PRIu64 " %" PRIu64 " %" PRIu64, c->output_length, c->output_checksum, c->output_last);
+    }
+    fprintf(f, "\nfiltered %zu\n", c->filtered->len);
+    for(size_t i = 0; i < c->filtered->len; i++) {
+        fprintf(f, "%" PRIu64 "\n", filtered[i]);
+    }
+    return !ferror(f);
+}
+
+bool checkpoint_save(Checkpoint const* c, char const* path, CaveError* err) {
+    if(c == NULL || c->filtered == NULL || path == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    size_t path_len = strlen(path);
+    char* tmp_path = malloc(path_len + sizeof(".tmp"));
+    if(tmp_path == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return false;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE* f = fopen(tmp_path, "w");
+    if(f == NULL) {
+        free(tmp_path);
+        *err = CAVE_FILE_ERROR;
+        return false;
+    }
+    //synced before the rename, so a crash leaves either the old checkpoint or the new one, never half of one.
+    bool ok = fprint_checkpoint(f, c) && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && rename(tmp_path, path) == 0;
+    if(!ok) {
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    *err = ok ? CAVE_NO_ERROR : CAVE_FILE_ERROR;
+    return ok;
+}
+
+static bool fscan_checkpoint(FILE* f, Checkpoint* c, CaveError* err) {
+    int version;
+    char output[16];
+    size_t filtered_len;
+    if(fscanf(f, "filtered-primes checkpoint %d", &version) != 1 || version != CHECKPOINT_VERSION
+       || fscanf(f, " bound %" SCNu64, &c->bound) != 1
+       || fscanf(f, " growth %lf", &c->growth) != 1
+       || fscanf(f, " position %" SCNu64, &c->position) != 1
+       || fscanf(f, " count %" SCNu64, &c->count) != 1
+       || fscanf(f, " output %15s", output) != 1) {
+        return false;
+    }
+    c->output_length = 0;
+    c->output_checksum = 0;
+    c->output_last = 0;
+    if(strcmp(output, output_names[CHECKPOINT_OUTPUT_NONE]) == 0) {
+        c->output = CHECKPOINT_OUTPUT_NONE;
+    } else if(strcmp(output, output_names[CHECKPOINT_OUTPUT_TEXT]) == 0) {
+        c->output = CHECKPOINT_OUTPUT_TEXT;
+        if(fscanf(f, " %" SCNu64, &c->output_length) != 1) {
+            return false;
+        }
+    } else if(strcmp(output, output_names[CHECKPOINT_OUTPUT_TABLE]) == 0) {
+        c->output = CHECKPOINT_OUTPUT_TABLE;
+        if(fscanf(f, " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                  &c->output_length, &c->output_checksum, &c->output_last) != 3) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    if(fscanf(f, " filtered %zu", &filtered_len) != 1 || filtered_len == 0) {
+        return false;
+    }
+    for(size_t i = 0; i < filtered_len; i++) {
+        uint64_t value;
+        if(fscanf(f, " %" SCNu64, &value) != 1) {
+            return false;
+        }
+        if(cave_vec_push(c->filtered, &value, err) == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Checkpoint* checkpoint_load(Checkpoint* c, char const* path, CaveVec* filtered, CaveError* err) {
+    if(c == NULL || path == NULL || filtered == NULL || filtered->len != 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    FILE* f = fopen(path, "r");
+    if(f == NULL) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    c->filtered = filtered;
+    *err = CAVE_NO_ERROR;
+    bool ok = fscan_checkpoint(f, c, err);
+    fclose(f);
+    if(!ok) {
+        if(*err == CAVE_NO_ERROR) {
+            *err = CAVE_DATA_ERROR;
+        }
+        return NULL;
+    }
+    return c;
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+CheckpointStage* checkpoint_stage_init(CheckpointStage* s, uint64_t position, double interval,
+                                       PRIME_BATCH_CLOSURE next, void* next_data,
+                                       CHECKPOINT_SAVE_CLOSURE save, void* save_data) {
+    s->next = next;
+    s->next_data = next_data;
+    s->save = save;
+    s->save_data = save_data;
+    s->position = position;
+    s->interval = interval;
+    s->due = monotonic_seconds() + interval;
+    return s;
+}
+
+void checkpoint_stage_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    CheckpointStage* s = closure_data;
+    s->next(primes, count, s->next_data, err);
+    if(*err != CAVE_NO_ERROR) {
+        return;
+    }
+    //batches come in ascending order, so once one has gone through, so has everything up to its last prime.
+    //There could be more primes between that and the next batch, so the position can't go any further.
+    if(count > 0) {
+        s->position = primes[count - 1] + 1;
+    }
+    //reading the clock is all a batch costs, when no checkpoint is due.
+    double now = monotonic_seconds();
+    if(now >= s->due) {
+        s->save(s->position, s->save_data, err);
+        s->due = now + s->interval;
+    }
+}
@@ -0,0 +1,243 @@
+#include "include/cli.h"
+#include "include/growth-filter.h"
+#include "include/checkpoint.h"
+#include "include/progress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+
+static char const* const ENGINE_NAMES[] = {
+        [CLI_ENGINE_PARALLEL] = "parallel",
+        [CLI_ENGINE_SIEVE] = "sieve",
+        [CLI_ENGINE_TRIAL] = "trial",
+        [CLI_ENGINE_DIRECT] = "direct",
+        [CLI_ENGINE_COUNT] = "count",
+};
+#define ENGINE_COUNT (sizeof(ENGINE_NAMES) / sizeof(ENGINE_NAMES[0]))
+
+static char const* const FORMAT_NAMES[] = {
+        [CLI_FORMAT_TEXT] = "text",
+        [CLI_FORMAT_BINARY] = "binary",
+        [CLI_FORMAT_C_HEADER] = "c-header",
+};
+#define FORMAT_COUNT (sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]))
+
+//where the filtered list goes in each format when --out isn't given.
+static char const* const DEFAULT_OUTS[] = {
+        [CLI_FORMAT_TEXT] = "out.txt",
+        [CLI_FORMAT_BINARY] = "out.bin",
+        [CLI_FORMAT_C_HEADER] = "filtered-primes-table.h",
+};
+
+void cli_options_default(CliOptions* o) {
+    *o = (CliOptions){
+        .bound = CLI_DEFAULT_BOUND,
+        .growth = GROWTH_FILTER_DEFAULT_FACTOR,
+        .engine = CLI_ENGINE_PARALLEL,
+        .threads = 0,
+        .segment_bytes = 0,
+        .wheel = WHEEL_210,
+        .out = NULL,
+        .format = CLI_FORMAT_TEXT,
+        .all_primes_out = NULL,
+        .checkpoint = NULL,
+        .checkpoint_interval = CHECKPOINT_DEFAULT_INTERVAL,
+        .resume = false,
+        .progress = false,
+        .progress_interval = PROGRESS_DEFAULT_INTERVAL,
+        .help = false,
+    };
+}
+
+char const* cli_engine_name(CliEngine engine) {
+    return (size_t)engine < ENGINE_COUNT ? ENGINE_NAMES[engine] : "unknown";
+}
+
+//reads a whole number, which may end in k, m or g for 2^10, 2^20 or 2^30 of them.
+static bool parse_uint64(char const* s, uint64_t* value) {
+    if(s[0] < '0' || s[0] > '9') {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    uint64_t v = strtoull(s, &end, 10);
+    if(errno != 0) {
+        return false;
+    }
+    unsigned shift = 0;
+    switch(*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+        default: break;
+    }
+    if(*end != '\0' || (v << shift) >> shift != v) {
+        return false;
+    }
+    *value = v << shift;
+    return true;
+}
+
+//finds s in names, which has count entries.
+static bool parse_name(char const* s, char const* const* names, size_t count, int* value) {
+    for(size_t i = 0; i < count; i++) {
+        if(strcmp(s, names[i]) == 0) {
+            *value = (int)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool cli_parse(CliOptions* o, int argc, char* argv[], FILE* errors) {
+    for(int i = 1; i < argc; i++) {
+        char const* arg = argv[i];
+
+        //the flags that don't take a value.
+        if(strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            o->help = true;
+            continue;
+        } else if(strcmp(arg, "--direct") == 0) {
+            o->engine = CLI_ENGINE_DIRECT;
+            continue;
+        } else if(strcmp(arg, "--count-only") == 0) {
+            o->engine = CLI_ENGINE_COUNT;
+            continue;
+        } else if(strcmp(arg, "--resume") == 0) {
+            o->resume = true;
+            continue;
+        } else if(strcmp(arg, "--progress") == 0) {
+            o->progress = true;
+            continue;
+        }
+
+        if(i + 1 >= argc) {
+            fprintf(errors, "Error: unknown argument %s\n", arg);
+            return false;
+        }
+        char const* value = argv[i + 1];
+        uint64_t number;
+        int named;
+        bool ok = true;
+        if(strcmp(arg, "--bound") == 0) {
+            ok = parse_uint64(value, &o->bound);
+        } else if(strcmp(arg, "--growth") == 0) {
+            char* end;
+            o->growth = strtod(value, &end);
+            ok = *end == '\0' && value[0] != '\0' && o->growth >= 1 && o->growth <= DBL_MAX;
+        } else if(strcmp(arg, "--engine") == 0) {
+            ok = parse_name(value, ENGINE_NAMES, ENGINE_COUNT, &named);
+            o->engine = ok ? (CliEngine)named : o->engine;
+        } else if(strcmp(arg, "--threads") == 0) {
+            ok = parse_uint64(value, &number) && number <= 4096;
+            o->threads = (size_t)number;
+        } else if(strcmp(arg, "--segment-size") == 0) {
+            //a segment has to hold at least one number, and has to be allocatable.
+            ok = parse_uint64(value, &number) && number >= 1 && number <= ((uint64_t)1 << 34);
+            o->segment_bytes = (size_t)number;
+        } else if(strcmp(arg, "--wheel") == 0) {
+            ok = parse_uint64(value, &number) && (number == WHEEL_30 || number == WHEEL_210);
+            o->wheel = (WheelKind)number;
+        } else if(strcmp(arg, "--out") == 0) {
+            o->out = value;
+        } else if(strcmp(arg, "--format") == 0) {
+            ok = parse_name(value, FORMAT_NAMES, FORMAT_COUNT, &named);
+            o->format = ok ? (CliFormat)named : o->format;
+        } else if(strcmp(arg, "--all-primes") == 0) {
+            o->all_primes_out = value;
+        } else if(strcmp(arg, "--checkpoint") == 0) {
+            o->checkpoint = value;
+        } else if(strcmp(arg, "--checkpoint-interval") == 0) {
+            char* end;
+            o->checkpoint_interval = strtod(value, &end);
+            ok = *end == '\0' && value[0] != '\0' && o->checkpoint_interval > 0 && o->checkpoint_interval <= DBL_MAX;
+        } else if(strcmp(arg, "--progress-interval") == 0) {
+            char* end;
+            o->progress_interval = strtod(value, &end);
+            //it ends up as a number of whole seconds to wait, so it has to fit in a time_t.
+            ok = *end == '\0' && value[0] != '\0' && o->progress_interval > 0 && o->progress_interval <= 1e9;
+        } else {
+            fprintf(errors, "Error: unknown argument %s\n", arg);
+            return false;
+        }
+        if(!ok) {
+            fprintf(errors, "Error: %s can't be %s (see --help)\n", arg, value);
+            return false;
+        }
+        i++;
+    }
+
+    if(o->help) {
+        return true;
+    }
+    if(o->all_primes_out != NULL) {
+        if(o->engine == CLI_ENGINE_DIRECT || o->engine == CLI_ENGINE_COUNT) {
+            fprintf(errors, "Error: --all-primes needs every prime to be found, which the %s engine skips\n",
+                    cli_engine_name(o->engine));
+            return false;
+        }
+        if(o->format == CLI_FORMAT_C_HEADER) {
+            fprintf(errors, "Error: --all-primes can be written as text or binary, but not as a c-header\n");
+            return false;
+        }
+    }
+    if(o->resume && o->checkpoint == NULL) {
+        fprintf(errors, "Error: --resume needs --checkpoint, to know where to resume from\n");
+        return false;
+    }
+    if(o->checkpoint != NULL && (o->engine == CLI_ENGINE_DIRECT || o->engine == CLI_ENGINE_COUNT)) {
+        fprintf(errors, "Error: the %s engine is over too quickly to need --checkpoint\n",
+                cli_engine_name(o->engine));
+        return false;
+    }
+    if(o->progress && (o->engine == CLI_ENGINE_DIRECT || o->engine == CLI_ENGINE_COUNT)) {
+        fprintf(errors, "Error: the %s engine doesn't go through the primes in order, so it has no --progress\n",
+                cli_engine_name(o->engine));
+        return false;
+    }
+    if(o->out == NULL) {
+        o->out = DEFAULT_OUTS[o->format];
+    }
+    return true;
+}
+
+void cli_print_usage(FILE* stream, char const* program) {
+    fprintf(stream,
+            "Usage: %s [options]\n"
+            "\n"
+            "Finds every prime below the bound, then keeps only the ones that are more than the growth factor\n"
+            "times the last one kept, starting from 2. The kept primes are printed, and written to --out.\n"
+            "\n"
+            "Options:\n"
+            "  --bound N          Only primes below N are considered. Default 12884901888.\n"
+            "  --growth G         The growth factor, at least 1. Default 1.5.\n"
+            "  --engine E         How the primes are found:\n"
+            "                       parallel  the segmented sieve on a pool of threads (default)\n"
+            "                       sieve     the segmented sieve on one thread\n"
+            "                       trial     trial division\n"
+            "                       direct    only the filtered primes, found with Miller-Rabin. Milliseconds.\n"
+            "                       count     only count the primes, with Lucy Hedgehog's method\n"
+            "  --direct           The same as --engine direct.\n"
+            "  --count-only       The same as --engine count.\n"
+            "  --threads T        Worker threads for the parallel engine. Default one per processor.\n"
+            "  --segment-size B   Bytes per sieve segment, each covering 2B numbers. Default 131072.\n"
+            "  --wheel W          30 or 210, the wheel candidates are drawn from. Default 210.\n"
+            "  --format F         text, binary (see include/prime-table.h) or c-header. Default text.\n"
+            "  --out PATH         Where the filtered primes are written. Default out.txt, out.bin or\n"
+            "                     filtered-primes-table.h, depending on the format.\n"
+            "  --all-primes PATH  Also write every prime found to PATH, as they're found, in the format.\n"
+            "  --checkpoint PATH  Save how far the run has got to PATH every so often, and remove it at the end.\n"
+            "  --checkpoint-interval S\n"
+            "                     Seconds between checkpoints. Default 60.\n"
+            "  --resume           Carry on from the checkpoint at --checkpoint, with the same bound, growth\n"
+            "                     factor and --all-primes as the run that saved it.\n"
+            "  --progress         Print how far the run has got, how fast it's going and how long is left to\n"
+            "                     stderr every so often.\n"
+            "  --progress-interval S\n"
+            "                     Seconds between progress lines. Default 10.\n"
+            "  --help             Print this and exit.\n"
+            "\n"
+            "Numbers can end in k, m or g for 2^10, 2^20 or 2^30 of them.\n",
+            program);
+}
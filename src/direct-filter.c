@@ -0,0 +1,48 @@
+#include "include/direct-filter.h"
+#include "include/growth-filter.h"
+#include "include/miller-rabin.h"
+
+//2^64 as a double. Anything at or past this can't be a uint64_t.
+#define TWO_POW_64 (18446744073709551616.0)
+
+CaveVec* direct_filtered_primes_below(CaveVec* filtered, uint64_t upperbound, double growth, CaveError* err) {
+    if(filtered == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    uint64_t prev_prime = 2;
+    if(cave_vec_push(filtered, &prev_prime, err) == NULL) {
+        return NULL;
+    }
+
+    while(true) {
+        double target = growth * (double)prev_prime;
+        if(target >= TWO_POW_64) {
+            break;
+        }
+        //start a little below the target. Once numbers are past 2^53, converting them to a double rounds,
+        //so a prime a few below the target can still compare as bigger than it, and the filter would keep it.
+        uint64_t start = target > 0 ? (uint64_t)target : 0;
+        uint64_t margin = (start >> 52) + 2;
+        start = start > margin ? start - margin : 0;
+        if(start <= prev_prime) {
+            start = prev_prime + 1;
+        }
+
+        uint64_t prime = miller_rabin_next_prime(start);
+        while(prime != 0 && prime < upperbound && !growth_filter_keeps(prime, prev_prime, growth)) {
+            prime = miller_rabin_next_prime(prime + 1);
+        }
+        if(prime == 0 || prime >= upperbound) {
+            break;
+        }
+
+        if(cave_vec_push(filtered, &prime, err) == NULL) {
+            return NULL;
+        }
+        prev_prime = prime;
+    }
+
+    *err = CAVE_NO_ERROR;
+    return filtered;
+}
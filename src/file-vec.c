@@ -0,0 +1,170 @@
+#ifdef __linux__
+//for mremap().
+#define _GNU_SOURCE
+#endif
+#include "include/file-vec.h"
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+//maps the first `bytes` of the file, which must already be that long.
+static void* map_file(int fd, size_t bytes) {
+    void* map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+CaveFileVec* cave_file_vec_init(CaveFileVec* v, char const* path, size_t element_size, size_t initial_capacity,
+                                CaveError* err) {
+    if(v == NULL || path == NULL || element_size == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    size_t capacity = initial_capacity > 0 ? initial_capacity : CAVE_VEC_DEFAULT_CAPACITY;
+    if(capacity > SIZE_MAX / element_size) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    v->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(v->fd < 0) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    //growing the file with ftruncate leaves a hole, so the space isn't taken up until it's written.
+    size_t bytes = capacity * element_size;
+    void* map = NULL;
+    if(ftruncate(v->fd, (off_t)bytes) != 0 || (map = map_file(v->fd, bytes)) == NULL) {
+        close(v->fd);
+        unlink(path);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    v->vec = (CaveVec){.data = map, .stride = element_size, .capacity = capacity, .len = 0};
+    *err = CAVE_NO_ERROR;
+    return v;
+}
+
+CaveFileVec* cave_file_vec_reserve(CaveFileVec* v, size_t capacity, CaveError* err) {
+    if(v == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    if(capacity <= v->vec.capacity) {
+        return v;
+    }
+    if(capacity > SIZE_MAX / v->vec.stride) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    size_t old_bytes = v->vec.capacity * v->vec.stride;
+    size_t bytes = capacity * v->vec.stride;
+    if(ftruncate(v->fd, (off_t)bytes) != 0) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    //the elements stay where they are in the file, so growing is only ever a matter of mapping more of it.
+    //mremap does that in place when it can, and moves the page tables rather than the data when it can't.
+#ifdef __linux__
+    void* map = mremap(v->vec.data, old_bytes, bytes, MREMAP_MAYMOVE);
+    map = map == MAP_FAILED ? NULL : map;
+#else
+    void* map = map_file(v->fd, bytes);
+    if(map != NULL) {
+        munmap(v->vec.data, old_bytes);
+    }
+#endif
+    if(map == NULL) {
+        //the old mapping is still good, so put the file back to match it. If that fails too, the file is only
+        //longer than it needs to be, and the release always cuts it down to the elements anyway.
+        int restored = ftruncate(v->fd, (off_t)old_bytes);
+        (void)restored;
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    v->vec.data = map;
+    v->vec.capacity = capacity;
+    return v;
+}
+
+//makes room for `count` more elements, growing by at least CAVE_VEC_GROW_FACTOR.
+static CaveFileVec* make_room(CaveFileVec* v, size_t count, CaveError* err) {
+    if(count > SIZE_MAX - v->vec.len) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    size_t needed = v->vec.len + count;
+    if(needed <= v->vec.capacity) {
+        *err = CAVE_NO_ERROR;
+        return v;
+    }
+    size_t grown = v->vec.capacity <= SIZE_MAX / CAVE_VEC_GROW_FACTOR ? v->vec.capacity * CAVE_VEC_GROW_FACTOR
+                                                                      : SIZE_MAX;
+    return cave_file_vec_reserve(v, grown > needed ? grown : needed, err);
+}
+
+CaveFileVec* cave_file_vec_push(CaveFileVec* v, void const* element, CaveError* err) {
+    if(v == NULL || element == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(make_room(v, 1, err) == NULL) {
+        return NULL;
+    }
+    memcpy(cave_file_vec_at_unchecked(v, v->vec.len), element, v->vec.stride);
+    v->vec.len++;
+    return v;
+}
+
+CaveFileVec* cave_file_vec_push_n(CaveFileVec* v, void const* elements, size_t count, CaveError* err) {
+    if(v == NULL || (elements == NULL && count != 0)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(make_room(v, count, err) == NULL) {
+        return NULL;
+    }
+    if(count > 0) {
+        memcpy(cave_file_vec_at_unchecked(v, v->vec.len), elements, count * v->vec.stride);
+    }
+    v->vec.len += count;
+    return v;
+}
+
+void* cave_file_vec_at(CaveFileVec const* v, size_t index, CaveError* err) {
+    if(v == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(index >= v->vec.len) {
+        *err = CAVE_INDEX_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return cave_file_vec_at_unchecked(v, index);
+}
+
+void cave_file_vec_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    cave_file_vec_push_n(closure_data, primes, count, err);
+}
+
+bool cave_file_vec_sync(CaveFileVec* v, CaveError* err) {
+    if(msync(v->vec.data, v->vec.capacity * v->vec.stride, MS_SYNC) != 0 || fsync(v->fd) != 0) {
+        *err = CAVE_FILE_ERROR;
+        return false;
+    }
+    *err = CAVE_NO_ERROR;
+    return true;
+}
+
+bool cave_file_vec_release(CaveFileVec* v, CaveError* err) {
+    bool ok = munmap(v->vec.data, v->vec.capacity * v->vec.stride) == 0;
+    //the spare capacity on the end is just a hole, but the file should hold exactly the elements.
+    ok = ftruncate(v->fd, (off_t)(v->vec.len * v->vec.stride)) == 0 && ok;
+    ok = close(v->fd) == 0 && ok;
+    v->vec = (CaveVec){.data = NULL, .stride = v->vec.stride, .capacity = 0, .len = 0};
+    v->fd = -1;
+    *err = ok ? CAVE_NO_ERROR : CAVE_FILE_ERROR;
+    return ok;
+}
@@ -0,0 +1,306 @@
+#include "include/hashmap.h"
+#include <stdlib.h>
+#include <string.h>
+#include "filtered-primes-table.h"
+
+#define CONTROL_EMPTY ((uint8_t)0)
+#define CONTROL_TOMBSTONE ((uint8_t)1)
+
+//the finalizer from splitmix64, which makes every bit of the output depend on every bit of the input.
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t cave_hash_bytes(void const* key, size_t key_size, void* closure_data) {
+    (void)closure_data;
+    unsigned char const* bytes = key;
+    uint64_t h = key_size;
+    size_t i = 0;
+    for(; i + 8 <= key_size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        h = mix(h ^ word);
+    }
+    if(i < key_size) {
+        uint64_t word = 0;
+        memcpy(&word, bytes + i, key_size - i);
+        h = mix(h ^ word);
+    }
+    return h;
+}
+
+static bool equal_bytes(void const* a, void const* b, size_t key_size, void* closure_data) {
+    (void)closure_data;
+    //8 byte keys are the common case, and a memcmp of unknown size is a call.
+    if(key_size == sizeof(uint64_t)) {
+        uint64_t x, y;
+        memcpy(&x, a, sizeof(uint64_t));
+        memcpy(&y, b, sizeof(uint64_t));
+        return x == y;
+    }
+    return memcmp(a, b, key_size) == 0;
+}
+
+//memcpy, but without the call when it's a uint64_t, or a uint64_t key and value, which is most of the time.
+static void copy_bytes(void* to, void const* from, size_t size) {
+    if(size == 8) {
+        memcpy(to, from, 8);
+    } else if(size == 16) {
+        memcpy(to, from, 16);
+    } else {
+        memcpy(to, from, size);
+    }
+}
+
+//whether a table of `capacity` slots may have `used` of them in use.
+static bool fits(uint64_t capacity, size_t used) {
+    return (unsigned __int128)used * CAVE_HASHMAP_MAX_LOAD_DENOMINATOR
+           <= (unsigned __int128)capacity * CAVE_HASHMAP_MAX_LOAD_NUMERATOR;
+}
+
+//where in the filtered prime table the first capacity with room for `used` slots is, or FILTERED_PRIMES_COUNT if
+//there isn't one.
+static size_t capacity_index_for(size_t used) {
+    size_t i = 0;
+    while(i < FILTERED_PRIMES_COUNT && !fits(filtered_primes[i], used)) {
+        i++;
+    }
+    return i;
+}
+
+//the control byte of a full slot whose key hashes to `hash`. The top bits, since the slot comes from all of them.
+static uint8_t control_for(uint64_t hash) {
+    return (uint8_t)(0x80 | (hash >> 57));
+}
+
+//the alignment an object of `size` bytes might need: the largest power of 2 that divides it, up to the most
+//any type needs.
+static size_t alignment_for(size_t size) {
+    size_t alignment = size & -size;
+    return alignment > 0 && alignment < _Alignof(max_align_t) ? alignment : _Alignof(max_align_t);
+}
+
+static size_t round_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static uint64_t next_slot(CaveHashMap const* m, uint64_t slot) {
+    slot++;
+    return slot == m->capacity ? 0 : slot;
+}
+
+static unsigned char* key_at(CaveHashMap const* m, uint64_t slot) {
+    return m->entries + slot * m->entry_size;
+}
+
+static void* value_at(CaveHashMap const* m, uint64_t slot) {
+    return key_at(m, slot) + (m->value_size > 0 ? m->value_offset : 0);
+}
+
+//the slot `key` is in, or UINT64_MAX if it isn't in the map.
+static uint64_t find(CaveHashMap const* m, void const* key, uint64_t hash) {
+    uint8_t control = control_for(hash);
+    uint64_t slot = cave_fastmod(hash, m->fastmod, m->capacity);
+    //the entry is usually in the first slot looked at, so it's fetched alongside the control byte.
+    __builtin_prefetch(key_at(m, slot));
+    //the load factor is below 1, so there's always an empty slot to stop at.
+    while(m->control[slot] != CONTROL_EMPTY) {
+        if(m->control[slot] == control && m->equals(key_at(m, slot), key, m->key_size, m->closure_data)) {
+            return slot;
+        }
+        slot = next_slot(m, slot);
+    }
+    return UINT64_MAX;
+}
+
+//the slot a key with this hash goes in, in a table with no tombstones that doesn't already hold the key.
+static uint64_t find_empty(uint8_t const* control, uint64_t capacity, unsigned __int128 fastmod, uint64_t hash) {
+    uint64_t slot = cave_fastmod(hash, fastmod, capacity);
+    while(control[slot] != CONTROL_EMPTY) {
+        slot = slot + 1 == capacity ? 0 : slot + 1;
+    }
+    return slot;
+}
+
+//allocates the slots for the capacity at `index`. On failure, nothing is allocated.
+static bool allocate_slots(CaveHashMap const* m, size_t index, uint8_t** control, unsigned char** entries) {
+    uint64_t capacity = filtered_primes[index];
+    bool too_big = capacity > SIZE_MAX / m->entry_size;
+    *control = too_big ? NULL : calloc(capacity, 1);
+    *entries = too_big ? NULL : malloc(capacity * m->entry_size);
+    if(*control == NULL || *entries == NULL) {
+        free(*control);
+        free(*entries);
+        return false;
+    }
+    return true;
+}
+
+//moves every key into a table with the capacity at `index`, dropping the tombstones.
+static bool rehash(CaveHashMap* m, size_t index) {
+    uint8_t* control;
+    unsigned char* entries;
+    if(!allocate_slots(m, index, &control, &entries)) {
+        return false;
+    }
+    uint64_t capacity = filtered_primes[index];
+    unsigned __int128 fastmod = cave_fastmod_constant(capacity);
+    for(uint64_t slot = 0; slot < m->capacity; slot++) {
+        if(m->control[slot] < 0x80) {
+            continue;
+        }
+        unsigned char const* entry = key_at(m, slot);
+        uint64_t hash = m->hash(entry, m->key_size, m->closure_data);
+        uint64_t to = find_empty(control, capacity, fastmod, hash);
+        control[to] = m->control[slot];
+        copy_bytes(entries + to * m->entry_size, entry, m->entry_size);
+    }
+    free(m->control);
+    free(m->entries);
+    m->control = control;
+    m->entries = entries;
+    m->capacity = capacity;
+    m->fastmod = fastmod;
+    m->capacity_index = index;
+    m->tombstones = 0;
+    return true;
+}
+
+CaveHashMap* cave_hashmap_init(CaveHashMap* m, size_t key_size, size_t value_size, size_t initial_capacity,
+                               CAVE_HASH_CLOSURE hash, CAVE_EQUALS_CLOSURE equals, void* closure_data,
+                               CaveError* err) {
+    if(m == NULL || key_size == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    m->key_size = key_size;
+    m->value_size = value_size;
+    //the value goes after the key, and each entry after the last, so they have to be padded to stay aligned.
+    size_t key_alignment = alignment_for(key_size);
+    size_t value_alignment = value_size > 0 ? alignment_for(value_size) : 1;
+    m->value_offset = round_up(key_size, value_alignment);
+    m->entry_size = round_up(m->value_offset + value_size,
+                             key_alignment > value_alignment ? key_alignment : value_alignment);
+    m->hash = hash != NULL ? hash : cave_hash_bytes;
+    m->equals = equals != NULL ? equals : equal_bytes;
+    m->closure_data = closure_data;
+    size_t index = capacity_index_for(initial_capacity > 0 ? initial_capacity : CAVE_HASHMAP_DEFAULT_CAPACITY);
+    if(index == FILTERED_PRIMES_COUNT || !allocate_slots(m, index, &m->control, &m->entries)) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    m->capacity = filtered_primes[index];
+    m->fastmod = cave_fastmod_constant(m->capacity);
+    m->capacity_index = index;
+    m->len = 0;
+    m->tombstones = 0;
+    *err = CAVE_NO_ERROR;
+    return m;
+}
+
+void* cave_hashmap_insert(CaveHashMap* m, void const* key, void const* value, CaveError* err) {
+    if(m == NULL || key == NULL || (value == NULL && m->value_size != 0)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    uint64_t hash = m->hash(key, m->key_size, m->closure_data);
+    uint8_t control = control_for(hash);
+    uint64_t slot = cave_fastmod(hash, m->fastmod, m->capacity);
+    __builtin_prefetch(key_at(m, slot));
+    uint64_t tombstone = UINT64_MAX;
+    while(m->control[slot] != CONTROL_EMPTY) {
+        if(m->control[slot] == control && m->equals(key_at(m, slot), key, m->key_size, m->closure_data)) {
+            break;
+        }
+        if(m->control[slot] == CONTROL_TOMBSTONE && tombstone == UINT64_MAX) {
+            tombstone = slot;
+        }
+        slot = next_slot(m, slot);
+    }
+
+    if(m->control[slot] == CONTROL_EMPTY) {
+        if(tombstone != UINT64_MAX) {
+            //reusing a tombstone doesn't use up another slot.
+            slot = tombstone;
+            m->tombstones--;
+        } else if(!fits(m->capacity, m->len + m->tombstones + 1)) {
+            //if clearing out the tombstones would make room, that's all that's done. Otherwise it grows.
+            size_t index = fits(m->capacity, m->len + 1) ? m->capacity_index
+                                                          : capacity_index_for(m->len + 1);
+            if(index == FILTERED_PRIMES_COUNT || !rehash(m, index)) {
+                *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+                return NULL;
+            }
+            slot = find_empty(m->control, m->capacity, m->fastmod, hash);
+        }
+        m->control[slot] = control;
+        copy_bytes(key_at(m, slot), key, m->key_size);
+        m->len++;
+    }
+    if(m->value_size > 0) {
+        copy_bytes(value_at(m, slot), value, m->value_size);
+    }
+    *err = CAVE_NO_ERROR;
+    return value_at(m, slot);
+}
+
+void* cave_hashmap_get(CaveHashMap const* m, void const* key, CaveError* err) {
+    if(m == NULL || key == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    uint64_t slot = find(m, key, m->hash(key, m->key_size, m->closure_data));
+    if(slot == UINT64_MAX) {
+        *err = CAVE_INDEX_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return value_at(m, slot);
+}
+
+bool cave_hashmap_remove(CaveHashMap* m, void const* key, CaveError* err) {
+    if(m == NULL || key == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    uint64_t slot = find(m, key, m->hash(key, m->key_size, m->closure_data));
+    if(slot == UINT64_MAX) {
+        *err = CAVE_INDEX_ERROR;
+        return false;
+    }
+    //a probe that reached this slot would stop at the next one anyway if it's empty, so then this one can be
+    //emptied too, rather than left as a tombstone.
+    if(m->control[next_slot(m, slot)] == CONTROL_EMPTY) {
+        m->control[slot] = CONTROL_EMPTY;
+    } else {
+        m->control[slot] = CONTROL_TOMBSTONE;
+        m->tombstones++;
+    }
+    m->len--;
+    *err = CAVE_NO_ERROR;
+    return true;
+}
+
+void cave_hashmap_clear(CaveHashMap* m) {
+    memset(m->control, CONTROL_EMPTY, m->capacity);
+    m->len = 0;
+    m->tombstones = 0;
+}
+
+void cave_hashmap_release(CaveHashMap* m) {
+    if(m == NULL) {
+        return;
+    }
+    free(m->control);
+    free(m->entries);
+    m->control = NULL;
+    m->entries = NULL;
+    m->capacity = 0;
+    m->len = 0;
+    m->tombstones = 0;
+}
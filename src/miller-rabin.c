@@ -0,0 +1,94 @@
+#include "include/miller-rabin.h"
+#include "include/wheel.h"
+#include <stddef.h>
+
+//(a * b) % m without overflowing. Relies on the compiler's 128 bit integers, which every 64 bit
+//target gcc and clang support.
+static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return (uint64_t)(((unsigned __int128)a * b) % m);
+}
+
+static uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t m) {
+    uint64_t result = 1;
+    base %= m;
+    while(exponent > 0) {
+        if(exponent & 1) {
+            result = mul_mod(result, base, m);
+        }
+        base = mul_mod(base, base, m);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+//true if `n` passes the strong probable prime test to `base`. n - 1 == d * 2^s, with d odd.
+static bool is_strong_probable_prime(uint64_t n, uint64_t base, uint64_t d, unsigned s) {
+    base %= n;
+    if(base == 0) {
+        return true;
+    }
+    uint64_t x = pow_mod(base, d, n);
+    if(x == 1 || x == n - 1) {
+        return true;
+    }
+    for(unsigned i = 1; i < s; i++) {
+        x = mul_mod(x, x, n);
+        if(x == n - 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool miller_rabin_is_prime(uint64_t n) {
+    //these bases are enough to make the test exact for every n < 2^64 (found by Jim Sinclair).
+    static uint64_t const bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    static uint64_t const small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+
+    if(n < 2) {
+        return false;
+    }
+    //cheap rejection of most composites, and handles the small primes the bases could divide.
+    for(size_t i = 0; i < sizeof(small_primes) / sizeof(small_primes[0]); i++) {
+        if(n == small_primes[i]) {
+            return true;
+        }
+        if(n % small_primes[i] == 0) {
+            return false;
+        }
+    }
+
+    uint64_t d = n - 1;
+    unsigned s = 0;
+    while((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for(size_t i = 0; i < sizeof(bases) / sizeof(bases[0]); i++) {
+        if(!is_strong_probable_prime(n, bases[i], d, s)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t miller_rabin_next_prime(uint64_t n) {
+    Wheel wheel;
+    wheel_init(&wheel, WHEEL_210);
+    //the wheel's own primes aren't candidates of it, so they're checked by hand.
+    for(uint32_t i = 0; i < wheel.prime_count; i++) {
+        if(n <= wheel.primes[i]) {
+            return wheel.primes[i];
+        }
+    }
+
+    WheelIter it;
+    wheel_iter_init(&it, &wheel, n);
+    //UINT64_MAX is never a candidate, so reaching it means running off the end.
+    for(uint64_t candidate = it.value; candidate != UINT64_MAX; candidate = wheel_iter_next(&it)) {
+        if(miller_rabin_is_prime(candidate)) {
+            return candidate;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#ifdef __linux__
+//for mremap().
+#define _GNU_SOURCE
+#endif
+#include "include/page-allocator.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+//used when /proc/meminfo can't be read. It's the huge page size on x86-64, and the usual one on arm64.
+#define DEFAULT_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+//the size of the huge pages MAP_HUGETLB hands out, from /proc/meminfo.
+static size_t huge_page_size(void) {
+    size_t size = DEFAULT_HUGE_PAGE_SIZE;
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    if(meminfo == NULL) {
+        return size;
+    }
+    char line[256];
+    unsigned long long kb;
+    while(fgets(line, sizeof(line), meminfo) != NULL) {
+        if(sscanf(line, "Hugepagesize: %llu kB", &kb) == 1 && kb > 0) {
+            size = (size_t)kb * 1024;
+            break;
+        }
+    }
+    fclose(meminfo);
+    return size;
+}
+
+CavePageAllocator* cave_page_allocator_init(CavePageAllocator* a, CaveHugePages huge_pages, bool prefault,
+                                            CaveError* err) {
+    if(a == NULL || (huge_pages != CAVE_HUGE_PAGES_NONE && huge_pages != CAVE_HUGE_PAGES_TRANSPARENT
+                     && huge_pages != CAVE_HUGE_PAGES_EXPLICIT)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    a->huge_pages = huge_pages;
+    a->prefault = prefault;
+    //transparent huge pages are only used for whole, aligned huge pages, so those mappings are rounded up to
+    //them too, or the tail of each would be left on normal pages.
+    long page = sysconf(_SC_PAGESIZE);
+    a->page_size = huge_pages != CAVE_HUGE_PAGES_NONE ? huge_page_size() : page > 0 ? (size_t)page : 4096;
+    *err = CAVE_NO_ERROR;
+    return a;
+}
+
+//rounds up to a whole number of pages, or gives 0 if that would overflow.
+static size_t round_to_pages(CavePageAllocator const* a, size_t bytes) {
+    size_t mask = a->page_size - 1;
+    bytes = bytes > 0 ? bytes : 1;
+    return bytes <= SIZE_MAX - mask ? (bytes + mask) & ~mask : 0;
+}
+
+//faults in `bytes` bytes from `map`, a page at a time. Every 4KB, in case some of it can't get huge pages after all.
+static void touch_pages(void* map, size_t bytes) {
+    for(size_t i = 0; i < bytes; i += 4096) {
+        ((volatile unsigned char*)map)[i] = 0;
+    }
+}
+
+//maps `bytes` bytes, which must be a whole number of pages.
+static void* map_pages(CavePageAllocator const* a, size_t bytes) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    int populate = 0;
+#ifdef MAP_POPULATE
+    populate = a->prefault ? MAP_POPULATE : 0;
+#endif
+    void* map = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(a->huge_pages == CAVE_HUGE_PAGES_EXPLICIT) {
+        map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags | populate | MAP_HUGETLB, -1, 0);
+        if(map != MAP_FAILED) {
+            return map;
+        }
+    }
+#endif
+#ifdef MADV_HUGEPAGE
+    if(a->huge_pages != CAVE_HUGE_PAGES_NONE) {
+        //the advice only counts for pages faulted in after it, so mmap can't be the one to populate them.
+        map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if(map == MAP_FAILED) {
+            return NULL;
+        }
+        madvise(map, bytes, MADV_HUGEPAGE);
+        if(populate != 0) {
+            touch_pages(map, bytes);
+        }
+        return map;
+    }
+#endif
+    map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags | populate, -1, 0);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static void* page_alloc(void* context, size_t bytes) {
+    CavePageAllocator* a = context;
+    size_t size = round_to_pages(a, bytes);
+    return size != 0 ? map_pages(a, size) : NULL;
+}
+
+static void page_free(void* context, void* ptr, size_t bytes) {
+    CavePageAllocator* a = context;
+    if(ptr != NULL) {
+        munmap(ptr, round_to_pages(a, bytes));
+    }
+}
+
+static void* page_realloc(void* context, void* ptr, size_t old_bytes, size_t new_bytes) {
+    CavePageAllocator* a = context;
+    if(ptr == NULL) {
+        return page_alloc(a, new_bytes);
+    }
+    size_t old_size = round_to_pages(a, old_bytes);
+    size_t new_size = round_to_pages(a, new_bytes);
+    if(new_size == 0) {
+        return NULL;
+    }
+    if(new_size <= old_size) {
+        //shrinking is done in place, by unmapping the pages past the new end.
+        if(new_size < old_size) {
+            munmap((unsigned char*)ptr + new_size, old_size - new_size);
+        }
+        return ptr;
+    }
+#ifdef MREMAP_MAYMOVE
+    //growing the mapping either extends it in place or moves its page tables somewhere with room, so the
+    //elements are never copied, and there's never a moment where the old and new memory are both taken.
+    void* grown = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+    if(grown != MAP_FAILED) {
+        //the huge page advice belongs to the mapping, so the new tail has it already.
+        if(a->prefault) {
+            touch_pages((unsigned char*)grown + old_size, new_size - old_size);
+        }
+        return grown;
+    }
+#endif
+    //without mremap (or if it fails, which it can for MAP_HUGETLB mappings on older kernels), it's copied.
+    void* moved = map_pages(a, new_size);
+    if(moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, ptr, old_bytes);
+    munmap(ptr, old_size);
+    return moved;
+}
+
+static void page_discard(void* context, void* ptr, size_t bytes) {
+    CavePageAllocator* a = context;
+    //the allocation was mapped as whole pages, so its last page can go too.
+    if(ptr != NULL) {
+        //private anonymous pages read as zeroes after this, and take no memory until they're written again.
+        madvise(ptr, round_to_pages(a, bytes), MADV_DONTNEED);
+    }
+}
+
+CaveAllocator cave_page_allocator(CavePageAllocator* a) {
+    return (CaveAllocator){.alloc = page_alloc, .realloc = page_realloc, .free = page_free,
+                           .discard = page_discard, .context = a};
+}
@@ -0,0 +1,320 @@
+#include "include/parallel-sieve.h"
+#include "include/sieve.h"
+#include "include/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+//a worker's queue of chunk indices. The owner takes from the front, thieves take from the back.
+typedef struct ChunkDeque {
+    pthread_mutex_t lock;
+    uint64_t* chunks;
+    size_t capacity;
+    size_t head;
+    size_t len;
+} ChunkDeque;
+
+//where a chunk's primes wait to be stitched. `done` is guarded by the pool's lock.
+typedef struct ChunkSlot {
+    CaveVec primes;
+    CaveError err;
+    bool done;
+} ChunkSlot;
+
+typedef struct SievePool SievePool;
+
+typedef struct SieveWorker {
+    SievePool* pool;
+    size_t id;
+    SieveCursor cursor;
+    pthread_t thread;
+} SieveWorker;
+
+struct SievePool {
+    Sieve sieve;
+    uint64_t chunk_span;
+    uint64_t chunk_count;
+    size_t window;
+    size_t thread_count;
+    //the deques, slots and workers, and the deques' chunk arrays, all live and die with the pool, so they're
+    //carved out of one arena rather than allocated one by one.
+    CaveArena arena;
+    ChunkDeque* deques;
+    ChunkSlot* slots;
+    SieveWorker* workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t chunk_done;
+    //chunks sitting in a deque that no worker has taken yet.
+    atomic_size_t queued;
+    atomic_bool stopping;
+};
+
+
+size_t parallel_sieve_default_thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+static void deque_push_back(ChunkDeque* d, uint64_t chunk) {
+    pthread_mutex_lock(&d->lock);
+    d->chunks[(d->head + d->len) % d->capacity] = chunk;
+    d->len++;
+    pthread_mutex_unlock(&d->lock);
+}
+
+static bool deque_pop_front(ChunkDeque* d, uint64_t* chunk) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if(d->len > 0) {
+        *chunk = d->chunks[d->head];
+        d->head = (d->head + 1) % d->capacity;
+        d->len--;
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static bool deque_pop_back(ChunkDeque* d, uint64_t* chunk) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if(d->len > 0) {
+        d->len--;
+        *chunk = d->chunks[(d->head + d->len) % d->capacity];
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+//own deque first, then go around the other workers looking for something to steal.
+static bool take_chunk(SievePool* pool, size_t id, uint64_t* chunk) {
+    if(deque_pop_front(&pool->deques[id], chunk)) {
+        return true;
+    }
+    for(size_t i = 1; i < pool->thread_count; i++) {
+        if(deque_pop_back(&pool->deques[(id + i) % pool->thread_count], chunk)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sieve_chunk(SievePool* pool, SieveCursor* cursor, uint64_t chunk) {
+    ChunkSlot* slot = &pool->slots[chunk % pool->window];
+    uint64_t low = chunk * pool->chunk_span;
+    uint64_t high = low <= UINT64_MAX - pool->chunk_span ? low + pool->chunk_span : UINT64_MAX;
+
+    CaveError err = CAVE_NO_ERROR;
+    cave_vec_clear(&slot->primes, &err);
+    sieve_cursor_seek(cursor, low, high);
+    while(sieve_cursor_next(cursor, &slot->primes, &err)) {}
+
+    pthread_mutex_lock(&pool->lock);
+    slot->err = err;
+    slot->done = true;
+    pthread_cond_broadcast(&pool->chunk_done);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void* worker_main(void* arg) {
+    SieveWorker* worker = arg;
+    SievePool* pool = worker->pool;
+
+    while(!atomic_load(&pool->stopping)) {
+        uint64_t chunk;
+        if(take_chunk(pool, worker->id, &chunk)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            sieve_chunk(pool, &worker->cursor, chunk);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while(atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stopping)) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+//frees everything in the pool. Only the first `worker_count` cursors and `slot_count` slots were initialized.
+static void pool_release(SievePool* pool, size_t worker_count, size_t slot_count) {
+    for(size_t i = 0; i < worker_count; i++) {
+        sieve_cursor_release(&pool->workers[i].cursor);
+    }
+    for(size_t i = 0; i < slot_count; i++) {
+        cave_vec_release(&pool->slots[i].primes);
+    }
+    if(pool->deques != NULL) {
+        for(size_t i = 0; i < pool->thread_count; i++) {
+            pthread_mutex_destroy(&pool->deques[i].lock);
+        }
+    }
+    cave_arena_release(&pool->arena);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->chunk_done);
+    sieve_release(&pool->sieve);
+}
+
+static SievePool* pool_init(SievePool* pool, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                            size_t thread_count, CaveError* err) {
+    if(sieve_init(&pool->sieve, upperbound, segment_bytes, wheel, err) == NULL) {
+        return NULL;
+    }
+    pool->thread_count = thread_count;
+    pool->window = thread_count * PARALLEL_SIEVE_CHUNKS_PER_THREAD;
+    pool->chunk_span = 2 * (uint64_t)pool->sieve.segment_bytes * PARALLEL_SIEVE_SEGMENTS_PER_CHUNK;
+    pool->chunk_count = upperbound / pool->chunk_span + (upperbound % pool->chunk_span != 0);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->stopping, false);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->chunk_done, NULL);
+
+    //each allocation may be padded out to the arena's alignment.
+    size_t deques_bytes = thread_count * sizeof(ChunkDeque);
+    size_t slots_bytes = pool->window * sizeof(ChunkSlot);
+    size_t workers_bytes = thread_count * sizeof(SieveWorker);
+    size_t chunks_bytes = pool->window * sizeof(uint64_t);
+    size_t arena_bytes = deques_bytes + slots_bytes + workers_bytes + thread_count * chunks_bytes
+                         + (3 + thread_count) * CAVE_ALLOCATOR_ALIGNMENT;
+    pool->deques = NULL;
+    if(cave_arena_init(&pool->arena, arena_bytes, err) == NULL) {
+        pool->thread_count = 0;
+        pool_release(pool, 0, 0);
+        return NULL;
+    }
+    pool->deques = cave_arena_alloc(&pool->arena, deques_bytes);
+    pool->slots = cave_arena_alloc(&pool->arena, slots_bytes);
+    pool->workers = cave_arena_alloc(&pool->arena, workers_bytes);
+    memset(pool->deques, 0, deques_bytes);
+    memset(pool->slots, 0, slots_bytes);
+    memset(pool->workers, 0, workers_bytes);
+    for(size_t i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].capacity = pool->window;
+        pool->deques[i].chunks = cave_arena_alloc(&pool->arena, chunks_bytes);
+    }
+    for(size_t i = 0; i < pool->window; i++) {
+        if(cave_vec_init(&pool->slots[i].primes, sizeof(uint64_t), 0, err) == NULL) {
+            pool_release(pool, 0, i);
+            return NULL;
+        }
+    }
+    for(size_t i = 0; i < thread_count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if(sieve_cursor_init(&pool->workers[i].cursor, &pool->sieve, 0, 0, err) == NULL) {
+            pool_release(pool, i, pool->window);
+            return NULL;
+        }
+    }
+
+    *err = CAVE_NO_ERROR;
+    return pool;
+}
+
+//tells the workers to finish up, and waits for the first `started` of them to do so.
+static void pool_stop(SievePool* pool, size_t started) {
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->stopping, true);
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for(size_t i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+}
+
+bool parallel_sieve_foreach_batch(uint64_t upperbound, size_t segment_bytes, WheelKind wheel, size_t thread_count,
+                                  PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err) {
+    return parallel_sieve_foreach_batch_from(0, upperbound, segment_bytes, wheel, thread_count, fn, closure_data, err);
+}
+
+bool parallel_sieve_foreach_batch_from(uint64_t start, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                                       size_t thread_count, PRIME_BATCH_CLOSURE fn, void* closure_data,
+                                       CaveError* err) {
+    if(fn == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    if(thread_count == 0) {
+        thread_count = parallel_sieve_default_thread_count();
+    }
+
+    SievePool pool;
+    if(pool_init(&pool, upperbound, segment_bytes, wheel, thread_count, err) == NULL) {
+        return false;
+    }
+    for(size_t i = 0; i < thread_count; i++) {
+        if(pthread_create(&pool.workers[i].thread, NULL, worker_main, &pool.workers[i]) != 0) {
+            pool_stop(&pool, i);
+            pool_release(&pool, thread_count, pool.window);
+            *err = CAVE_UNKNOWN_ERROR;
+            return false;
+        }
+    }
+
+    *err = CAVE_NO_ERROR;
+    //chunks before the one holding start are skipped entirely, and the primes before start are trimmed from it.
+    uint64_t first_chunk = start / pool.chunk_span;
+    uint64_t next_dispatch = first_chunk;
+    for(uint64_t next_stitch = first_chunk; next_stitch < pool.chunk_count; next_stitch++) {
+        //keep the window full. The slot a chunk writes into is only reused once it has been stitched.
+        bool dispatched = false;
+        while(next_dispatch < pool.chunk_count && next_dispatch < next_stitch + pool.window) {
+            deque_push_back(&pool.deques[next_dispatch % thread_count], next_dispatch);
+            atomic_fetch_add(&pool.queued, 1);
+            next_dispatch++;
+            dispatched = true;
+        }
+        if(dispatched) {
+            pthread_mutex_lock(&pool.lock);
+            pthread_cond_broadcast(&pool.work_ready);
+            pthread_mutex_unlock(&pool.lock);
+        }
+
+        ChunkSlot* slot = &pool.slots[next_stitch % pool.window];
+        pthread_mutex_lock(&pool.lock);
+        while(!slot->done) {
+            pthread_cond_wait(&pool.chunk_done, &pool.lock);
+        }
+        slot->done = false;
+        pthread_mutex_unlock(&pool.lock);
+
+        if(slot->err != CAVE_NO_ERROR) {
+            *err = slot->err;
+            break;
+        }
+        uint64_t const* primes = slot->primes.data;
+        size_t skip = 0;
+        while(next_stitch == first_chunk && skip < slot->primes.len && primes[skip] < start) {
+            skip++;
+        }
+        fn(primes + skip, slot->primes.len - skip, closure_data, err);
+        if(*err != CAVE_NO_ERROR) {
+            break;
+        }
+    }
+
+    pool_stop(&pool, thread_count);
+    pool_release(&pool, thread_count, pool.window);
+    return *err == CAVE_NO_ERROR;
+}
+
+CaveVec* parallel_sieve_primes_below(CaveVec* primes, uint64_t upperbound, size_t segment_bytes,
+                                     WheelKind wheel, size_t thread_count, CaveError* err) {
+    if(primes == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(!parallel_sieve_foreach_batch(upperbound, segment_bytes, wheel, thread_count, prime_batch_push, primes, err)) {
+        return NULL;
+    }
+    return primes;
+}
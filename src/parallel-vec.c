@@ -0,0 +1,301 @@
+#include "include/parallel-vec.h"
+#include "include/parallel-sieve.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+//how many elements a thread gets through between looking to see whether another thread has failed.
+#define FAILED_CHECK_INTERVAL (1024)
+
+typedef enum VecPass {
+    VEC_PASS_FOREACH,
+    VEC_PASS_FILTER,
+    VEC_PASS_MAP,
+} VecPass;
+
+//one thread's share of a pass: the elements [begin, end) of `src`.
+typedef struct VecRange {
+    VecPass pass;
+    unsigned char* src;
+    size_t src_stride;
+    //the output for a map, NULL otherwise.
+    unsigned char* dest;
+    size_t dest_stride;
+    size_t begin;
+    size_t end;
+    CAVE_FOREACH_CLOSURE foreach_fn;
+    CAVE_FILTER_CLOSURE filter_fn;
+    CAVE_MAP_CLOSURE map_fn;
+    void* closure_data;
+    //set by the first range to fail, so the others can stop early.
+    atomic_bool* failed;
+
+    //for a filter, how many elements were kept, which are now at the front of the range, and the index they're
+    //moved down to once every range is done.
+    size_t kept;
+    size_t to;
+    CaveError err;
+    pthread_t thread;
+} VecRange;
+
+//the three passes, over [begin, end) of the range. Each returns early if the closure sets an error.
+
+static void foreach_block(VecRange* r, size_t begin, size_t end) {
+    for(size_t i = begin; i < end && r->err == CAVE_NO_ERROR; i++) {
+        r->foreach_fn(r->src + i * r->src_stride, r->closure_data, &r->err);
+    }
+}
+
+static void filter_block(VecRange* r, size_t begin, size_t end) {
+    size_t stride = r->src_stride;
+    for(size_t i = begin; i < end; i++) {
+        unsigned char* element = r->src + i * stride;
+        bool keep = r->filter_fn(element, r->closure_data, &r->err);
+        if(r->err != CAVE_NO_ERROR) {
+            return;
+        }
+        //never ahead of i, so nothing not yet visited is overwritten, and until something is dropped it's the
+        //element itself, which isn't copied. Otherwise it's a whole element behind, so the two can't overlap. A
+        //uint64_t is copied as one, since it's what this program filters, and a memcpy of unknown size is a call.
+        unsigned char* to = r->src + (r->begin + r->kept) * stride;
+        if(to != element) {
+            if(stride == sizeof(uint64_t)) {
+                memcpy(to, element, sizeof(uint64_t));
+            } else {
+                memcpy(to, element, stride);
+            }
+        }
+        r->kept += keep;
+    }
+}
+
+static void map_block(VecRange* r, size_t begin, size_t end) {
+    for(size_t i = begin; i < end && r->err == CAVE_NO_ERROR; i++) {
+        r->map_fn(r->src + i * r->src_stride, r->dest + i * r->dest_stride, r->closure_data, &r->err);
+    }
+}
+
+static void* run_range(void* arg) {
+    VecRange* r = arg;
+    r->err = CAVE_NO_ERROR;
+    r->kept = 0;
+    for(size_t begin = r->begin; begin < r->end; begin += FAILED_CHECK_INTERVAL) {
+        size_t end = r->end - begin > FAILED_CHECK_INTERVAL ? begin + FAILED_CHECK_INTERVAL : r->end;
+        switch(r->pass) {
+            case VEC_PASS_FOREACH:
+                foreach_block(r, begin, end);
+                break;
+            case VEC_PASS_FILTER:
+                filter_block(r, begin, end);
+                break;
+            case VEC_PASS_MAP:
+                map_block(r, begin, end);
+                break;
+        }
+        if(r->err != CAVE_NO_ERROR) {
+            atomic_store_explicit(r->failed, true, memory_order_relaxed);
+            break;
+        }
+        if(atomic_load_explicit(r->failed, memory_order_relaxed)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+//the number of ranges to cut `len` elements into.
+static size_t range_count(size_t len, size_t thread_count) {
+    //asking how many processors there are is a syscall or two, which is a lot to a short vector.
+    if(len < 2 * PARALLEL_VEC_MIN_RANGE) {
+        return 1;
+    }
+    if(thread_count == 0) {
+        thread_count = parallel_sieve_default_thread_count();
+    }
+    size_t most = len / PARALLEL_VEC_MIN_RANGE;
+    size_t count = thread_count < most ? thread_count : most;
+    return count > 0 ? count : 1;
+}
+
+//runs `template`'s pass over [0, len) cut into `count` ranges, the first on this thread. `ranges` has room for
+//`count`. Returns the error from the earliest range that failed.
+static CaveError run_ranges(VecRange const* template, size_t len, VecRange* ranges, size_t count) {
+    atomic_bool failed;
+    atomic_init(&failed, false);
+    for(size_t i = 0; i < count; i++) {
+        ranges[i] = *template;
+        ranges[i].begin = len / count * i + (i < len % count ? i : len % count);
+        ranges[i].end = ranges[i].begin + len / count + (i < len % count);
+        ranges[i].failed = &failed;
+    }
+    //a range whose thread can't be started is just run here instead, after the first.
+    bool* started = calloc(count, sizeof(bool));
+    for(size_t i = 1; i < count && started != NULL; i++) {
+        started[i] = pthread_create(&ranges[i].thread, NULL, run_range, &ranges[i]) == 0;
+    }
+    run_range(&ranges[0]);
+    for(size_t i = 1; i < count; i++) {
+        if(started != NULL && started[i]) {
+            pthread_join(ranges[i].thread, NULL);
+        } else {
+            run_range(&ranges[i]);
+        }
+    }
+    free(started);
+
+    for(size_t i = 0; i < count; i++) {
+        if(ranges[i].err != CAVE_NO_ERROR) {
+            return ranges[i].err;
+        }
+    }
+    return CAVE_NO_ERROR;
+}
+
+static void* move_range(void* arg) {
+    VecRange* r = arg;
+    memmove(r->src + r->to * r->src_stride, r->src + r->begin * r->src_stride, r->kept * r->src_stride);
+    return NULL;
+}
+
+//moves each range's kept elements down to its `to`, a thread per range. A range's elements may only go where an
+//earlier range's elements still are (never a later one's), so this goes in rounds: each round moves every range
+//whose destination is clear of the ranges still to move. When few elements are kept, as when filtering primes,
+//they're all clear, and it takes one round.
+static void move_ranges(VecRange* ranges, size_t count) {
+    bool* pending = malloc(count * sizeof(bool));
+    size_t* round = malloc(count * sizeof(size_t));
+    if(pending == NULL || round == NULL) {
+        //it can still be done a range at a time, in order, which never overwrites anything still needed.
+        for(size_t i = 0; i < count; i++) {
+            move_range(&ranges[i]);
+        }
+        free(pending);
+        free(round);
+        return;
+    }
+    size_t left = 0;
+    for(size_t i = 0; i < count; i++) {
+        pending[i] = ranges[i].kept > 0 && ranges[i].to != ranges[i].begin;
+        left += pending[i];
+    }
+
+    while(left > 0) {
+        size_t round_len = 0;
+        for(size_t i = 0; i < count; i++) {
+            if(!pending[i]) {
+                continue;
+            }
+            bool clear = true;
+            for(size_t j = 0; j < i && clear; j++) {
+                clear = !pending[j] || ranges[i].to + ranges[i].kept <= ranges[j].begin
+                        || ranges[j].begin + ranges[j].kept <= ranges[i].to;
+            }
+            if(clear) {
+                round[round_len++] = i;
+            }
+        }
+        //the earliest pending range is always clear, so every round moves at least one.
+        bool* started = calloc(round_len, sizeof(bool));
+        for(size_t k = 1; k < round_len && started != NULL; k++) {
+            started[k] = pthread_create(&ranges[round[k]].thread, NULL, move_range, &ranges[round[k]]) == 0;
+        }
+        move_range(&ranges[round[0]]);
+        for(size_t k = 1; k < round_len; k++) {
+            if(started != NULL && started[k]) {
+                pthread_join(ranges[round[k]].thread, NULL);
+            } else {
+                move_range(&ranges[round[k]]);
+            }
+        }
+        free(started);
+        for(size_t k = 0; k < round_len; k++) {
+            pending[round[k]] = false;
+        }
+        left -= round_len;
+    }
+    free(pending);
+    free(round);
+}
+
+CaveVec* cave_vec_parallel_foreach(CaveVec* v, size_t thread_count, CAVE_FOREACH_CLOSURE fn, void* closure_data,
+                                   CaveError* err) {
+    if(v == NULL || fn == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    size_t count = range_count(v->len, thread_count);
+    VecRange* ranges = malloc(count * sizeof(VecRange));
+    if(ranges == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    VecRange template = {.pass = VEC_PASS_FOREACH, .src = v->data, .src_stride = v->stride,
+                         .foreach_fn = fn, .closure_data = closure_data};
+    *err = run_ranges(&template, v->len, ranges, count);
+    free(ranges);
+    return *err == CAVE_NO_ERROR ? v : NULL;
+}
+
+CaveVec* cave_vec_parallel_filter(CaveVec* v, size_t thread_count, CAVE_FILTER_CLOSURE fn, void* closure_data,
+                                  CaveError* err) {
+    if(v == NULL || fn == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    size_t count = range_count(v->len, thread_count);
+    VecRange* ranges = malloc(count * sizeof(VecRange));
+    if(ranges == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    VecRange template = {.pass = VEC_PASS_FILTER, .src = v->data, .src_stride = v->stride,
+                         .filter_fn = fn, .closure_data = closure_data};
+    *err = run_ranges(&template, v->len, ranges, count);
+    if(*err != CAVE_NO_ERROR) {
+        free(ranges);
+        return NULL;
+    }
+
+    //each range's kept elements go straight after the ones before it, which is never past where they are now.
+    size_t len = 0;
+    for(size_t i = 0; i < count; i++) {
+        ranges[i].to = len;
+        len += ranges[i].kept;
+    }
+    move_ranges(ranges, count);
+    free(ranges);
+    v->len = len;
+    return v;
+}
+
+CaveVec* cave_vec_parallel_map(CaveVec* dest, CaveVec const* src, size_t output_stride, size_t thread_count,
+                               CAVE_MAP_CLOSURE fn, void* closure_data, CaveError* err) {
+    if(dest == NULL || src == NULL || fn == NULL || output_stride == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    size_t count = range_count(src->len, thread_count);
+    VecRange* ranges = malloc(count * sizeof(VecRange));
+    if(ranges == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    if(cave_vec_init(dest, output_stride, src->len, err) == NULL) {
+        free(ranges);
+        return NULL;
+    }
+    VecRange template = {.pass = VEC_PASS_MAP, .src = src->data, .src_stride = src->stride,
+                         .dest = dest->data, .dest_stride = output_stride,
+                         .map_fn = fn, .closure_data = closure_data};
+    *err = run_ranges(&template, src->len, ranges, count);
+    free(ranges);
+    if(*err != CAVE_NO_ERROR) {
+        cave_vec_release(dest);
+        return NULL;
+    }
+    //the ranges wrote the elements straight into dest's buffer, so all that's left is to say they're there.
+    dest->len = src->len;
+    return dest;
+}
@@ -0,0 +1,60 @@
+#include "include/pipeline.h"
+#include "include/growth-filter.h"
+
+PrimePipeline* prime_pipeline_init(PrimePipeline* p, CaveVec* filtered, double growth,
+                                   PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err) {
+    if(p == NULL || filtered == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    p->count = 0;
+    p->growth = growth;
+    p->prev_prime = 2;
+    p->filtered = filtered;
+    p->next = next;
+    p->next_data = next_data;
+    if(cave_vec_push(filtered, &p->prev_prime, err) == NULL) {
+        return NULL;
+    }
+    return p;
+}
+
+PrimePipeline* prime_pipeline_resume(PrimePipeline* p, CaveVec* filtered, double growth, uint64_t count,
+                                     PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err) {
+    if(p == NULL || filtered == NULL || filtered->len == 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    p->count = count;
+    p->growth = growth;
+    //the filter only ever compares against the last prime it kept.
+    p->prev_prime = ((uint64_t const*)filtered->data)[filtered->len - 1];
+    p->filtered = filtered;
+    p->next = next;
+    p->next_data = next_data;
+    *err = CAVE_NO_ERROR;
+    return p;
+}
+
+void prime_pipeline_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    PrimePipeline* p = closure_data;
+    *err = CAVE_NO_ERROR;
+    p->count += count;
+
+    //the filter keeps so few primes that it's worth skipping straight past the ones it can't possibly keep.
+    //Primes in a batch ascend, so if the last one isn't kept, none of them are.
+    if(count > 0 && growth_filter_keeps(primes[count - 1], p->prev_prime, p->growth)) {
+        for(size_t i = 0; i < count; i++) {
+            if(growth_filter_keeps(primes[i], p->prev_prime, p->growth)) {
+                if(cave_vec_push(p->filtered, &primes[i], err) == NULL) {
+                    return;
+                }
+                p->prev_prime = primes[i];
+            }
+        }
+    }
+
+    if(p->next != NULL) {
+        p->next(primes, count, p->next_data, err);
+    }
+}
@@ -0,0 +1,57 @@
+#include "include/prime-count.h"
+#include "include/base-primes.h"
+#include <stdlib.h>
+
+uint64_t prime_count_below(uint64_t upperbound, CaveError* err) {
+    *err = CAVE_NO_ERROR;
+    if(upperbound < 3) {
+        return 0;
+    }
+    uint64_t n = upperbound - 1;
+    uint64_t r = isqrt_u64(n);
+
+    //small[v] is the count for v, for v <= r. large[i] is the count for n / i, for i <= r.
+    //Both start out as the count of 2..v, and are whittled down to the count of primes up to v.
+    uint64_t* small = malloc((r + 1) * sizeof(uint64_t));
+    uint64_t* large = malloc((r + 1) * sizeof(uint64_t));
+    if(small == NULL || large == NULL) {
+        free(small);
+        free(large);
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return 0;
+    }
+    small[0] = 0;
+    for(uint64_t v = 1; v <= r; v++) {
+        small[v] = v - 1;
+        large[v] = n / v - 1;
+    }
+
+    for(uint64_t p = 2; p <= r; p++) {
+        if(small[p] == small[p - 1]) {
+            //p was sieved out, so it isn't prime.
+            continue;
+        }
+        //the count of primes below p. Numbers up to v whose smallest prime factor is p are
+        //p * (anything up to v / p that survived sieving by the primes below p).
+        uint64_t below_p = small[p - 1];
+        uint64_t p_squared = p * p;
+
+        //large[i] covers n / i, which is only affected while n / i >= p^2.
+        uint64_t i_end = n / p_squared < r ? n / p_squared : r;
+        for(uint64_t i = 1; i <= i_end; i++) {
+            //(n / i) / p == n / (i * p), which is a large value while i * p <= r.
+            uint64_t ip = i * p;
+            uint64_t quotient_count = ip <= r ? large[ip] : small[n / ip];
+            large[i] -= quotient_count - below_p;
+        }
+        //going downwards, so small[v / p] hasn't been updated for this p yet.
+        for(uint64_t v = r; v >= p_squared; v--) {
+            small[v] -= small[v / p] - below_p;
+        }
+    }
+
+    uint64_t count = large[1];
+    free(small);
+    free(large);
+    return count;
+}
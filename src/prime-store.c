@@ -0,0 +1,179 @@
+#include "include/prime-store.h"
+
+//the most bytes an escaped gap can take: the 0 byte plus a 10 byte varint.
+#define MAX_ENCODED_GAP_BYTES (11)
+
+PrimeStore* prime_store_init(PrimeStore* s, CaveError* err) {
+    if(s == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(cave_vec_init(&s->gaps, sizeof(uint8_t), 0, err) == NULL) {
+        return NULL;
+    }
+    if(cave_vec_init(&s->blocks, sizeof(PrimeStoreBlock), 0, err) == NULL) {
+        cave_vec_release(&s->gaps);
+        return NULL;
+    }
+    s->last = 0;
+    s->len = 0;
+    return s;
+}
+
+void prime_store_release(PrimeStore* s) {
+    if(s == NULL) {
+        return;
+    }
+    cave_vec_release(&s->gaps);
+    cave_vec_release(&s->blocks);
+    s->len = 0;
+}
+
+//makes room for `extra` more bytes of gaps, growing geometrically so pushing stays amortized constant time.
+static bool reserve_gaps(PrimeStore* s, size_t extra, CaveError* err) {
+    size_t needed = s->gaps.len + extra;
+    if(needed <= s->gaps.capacity) {
+        return true;
+    }
+    size_t capacity = s->gaps.capacity * CAVE_VEC_GROW_FACTOR;
+    if(capacity < needed) {
+        capacity = needed;
+    }
+    return cave_vec_reserve(&s->gaps, capacity, err) != NULL;
+}
+
+static bool push_gap(PrimeStore* s, uint64_t gap, CaveError* err) {
+    uint8_t byte;
+    if(gap % 2 == 0 && gap / 2 >= 1 && gap / 2 <= UINT8_MAX) {
+        byte = (uint8_t)(gap / 2);
+        return cave_vec_push(&s->gaps, &byte, err) != NULL;
+    }
+    //escaped: a 0, then the gap as a varint, 7 bits at a time, low bits first.
+    byte = 0;
+    if(cave_vec_push(&s->gaps, &byte, err) == NULL) {
+        return false;
+    }
+    do {
+        byte = (uint8_t)(gap & 0x7f);
+        gap >>= 7;
+        if(gap != 0) {
+            byte |= 0x80;
+        }
+        if(cave_vec_push(&s->gaps, &byte, err) == NULL) {
+            return false;
+        }
+    } while(gap != 0);
+    return true;
+}
+
+PrimeStore* prime_store_push(PrimeStore* s, uint64_t prime, CaveError* err) {
+    if(s == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    return prime_store_push_n(s, &prime, 1, err);
+}
+
+PrimeStore* prime_store_push_n(PrimeStore* s, uint64_t const* primes, size_t count, CaveError* err) {
+    if(s == NULL || primes == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    //nearly every gap is one byte, so this is almost always the only reallocation.
+    if(!reserve_gaps(s, count, err)) {
+        return NULL;
+    }
+    for(size_t i = 0; i < count; i++) {
+        uint64_t prime = primes[i];
+        if(s->len > 0 && prime < s->last) {
+            *err = CAVE_DATA_ERROR;
+            return NULL;
+        }
+        if(s->len % PRIME_STORE_BLOCK_SIZE == 0) {
+            PrimeStoreBlock block = {prime, s->gaps.len};
+            if(cave_vec_push(&s->blocks, &block, err) == NULL) {
+                return NULL;
+            }
+        } else {
+            if(!reserve_gaps(s, MAX_ENCODED_GAP_BYTES, err) || !push_gap(s, prime - s->last, err)) {
+                return NULL;
+            }
+        }
+        s->last = prime;
+        s->len++;
+    }
+    *err = CAVE_NO_ERROR;
+    return s;
+}
+
+uint64_t prime_store_at(PrimeStore const* s, size_t index, CaveError* err) {
+    if(s == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return 0;
+    }
+    if(index >= s->len) {
+        *err = CAVE_INDEX_ERROR;
+        return 0;
+    }
+    PrimeStoreIter it;
+    prime_store_iter_init(&it, s, index);
+    uint64_t prime = 0;
+    prime_store_iter_next(&it, &prime);
+    *err = CAVE_NO_ERROR;
+    return prime;
+}
+
+size_t prime_store_bytes(PrimeStore const* s) {
+    return s->gaps.capacity * s->gaps.stride + s->blocks.capacity * s->blocks.stride;
+}
+
+PrimeStoreIter* prime_store_iter_init(PrimeStoreIter* it, PrimeStore const* s, size_t index) {
+    it->store = s;
+    it->prev = 0;
+    it->offset = 0;
+    if(index >= s->len) {
+        it->index = s->len;
+        return it;
+    }
+    //start from the block the index is in, and walk up to it.
+    it->index = index - index % PRIME_STORE_BLOCK_SIZE;
+    uint64_t skipped;
+    while(it->index < index) {
+        prime_store_iter_next(it, &skipped);
+    }
+    return it;
+}
+
+bool prime_store_iter_next(PrimeStoreIter* it, uint64_t* prime) {
+    PrimeStore const* s = it->store;
+    if(it->index >= s->len) {
+        return false;
+    }
+
+    uint64_t value;
+    if(it->index % PRIME_STORE_BLOCK_SIZE == 0) {
+        PrimeStoreBlock const* block = (PrimeStoreBlock const*)s->blocks.data + it->index / PRIME_STORE_BLOCK_SIZE;
+        value = block->first;
+        it->offset = block->gap_offset;
+    } else {
+        uint8_t const* gaps = s->gaps.data;
+        uint8_t byte = gaps[it->offset++];
+        if(byte != 0) {
+            value = it->prev + 2 * (uint64_t)byte;
+        } else {
+            uint64_t gap = 0;
+            unsigned shift = 0;
+            do {
+                byte = gaps[it->offset++];
+                gap |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+            } while(byte & 0x80);
+            value = it->prev + gap;
+        }
+    }
+
+    it->prev = value;
+    it->index++;
+    *prime = value;
+    return true;
+}
@@ -0,0 +1,303 @@
+#include "include/prime-table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//values are encoded into a buffer of this many before being handed to stdio.
+#define ENCODE_CHUNK (4096)
+
+static void store_le(unsigned char* bytes, uint64_t value, uint32_t width) {
+    for(uint32_t i = 0; i < width; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static void encode_header(unsigned char bytes[PRIME_TABLE_HEADER_BYTES], PrimeTableHeader const* h) {
+    memset(bytes, 0, PRIME_TABLE_HEADER_BYTES);
+    memcpy(bytes, PRIME_TABLE_MAGIC, sizeof(PRIME_TABLE_MAGIC));
+    store_le(bytes + 8, h->version, 4);
+    store_le(bytes + 12, h->element_width, 4);
+    store_le(bytes + 16, h->bound, 8);
+    store_le(bytes + 24, h->count, 8);
+    uint64_t growth_bits;
+    memcpy(&growth_bits, &h->growth, sizeof(growth_bits));
+    store_le(bytes + 32, growth_bits, 8);
+    store_le(bytes + 40, h->checksum, 8);
+}
+
+static bool decode_header(unsigned char const bytes[PRIME_TABLE_HEADER_BYTES], PrimeTableHeader* h) {
+    if(memcmp(bytes, PRIME_TABLE_MAGIC, sizeof(PRIME_TABLE_MAGIC)) != 0) {
+        return false;
+    }
+    h->version = (uint32_t)prime_table_load_le(bytes + 8, 4);
+    h->element_width = (uint32_t)prime_table_load_le(bytes + 12, 4);
+    h->bound = prime_table_load_le(bytes + 16, 8);
+    h->count = prime_table_load_le(bytes + 24, 8);
+    uint64_t growth_bits = prime_table_load_le(bytes + 32, 8);
+    memcpy(&h->growth, &growth_bits, sizeof(growth_bits));
+    h->checksum = prime_table_load_le(bytes + 40, 8);
+    return true;
+}
+
+static void free_paths(PrimeTableWriter* w) {
+    free(w->path);
+    free(w->tmp_path);
+    w->path = NULL;
+    w->tmp_path = NULL;
+}
+
+//sets up the writer's paths. The temporary path is `path` with ".tmp" on the end.
+static bool init_paths(PrimeTableWriter* w, char const* path) {
+    size_t path_len = strlen(path);
+    w->path = malloc(path_len + 1);
+    w->tmp_path = malloc(path_len + sizeof(".tmp"));
+    if(w->path == NULL || w->tmp_path == NULL) {
+        free_paths(w);
+        return false;
+    }
+    memcpy(w->path, path, path_len + 1);
+    memcpy(w->tmp_path, path, path_len);
+    memcpy(w->tmp_path + path_len, ".tmp", sizeof(".tmp"));
+    return true;
+}
+
+PrimeTableWriter* prime_table_writer_open(PrimeTableWriter* w, char const* path, uint64_t bound, double growth,
+                                          uint32_t element_width, CaveError* err) {
+    if(w == NULL || path == NULL || (element_width != 4 && element_width != 8)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(!init_paths(w, path)) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+
+    w->file = fopen(w->tmp_path, "wb");
+    if(w->file == NULL) {
+        free_paths(w);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    w->header = (PrimeTableHeader){
+        .version = PRIME_TABLE_VERSION,
+        .element_width = element_width,
+        .bound = bound,
+        .count = 0,
+        .growth = growth,
+        .checksum = PRIME_TABLE_CHECKSUM_SEED,
+    };
+    w->last = 0;
+
+    //the header is written again at the end, once the count and checksum are known. For now it just holds
+    //the space.
+    unsigned char header[PRIME_TABLE_HEADER_BYTES];
+    encode_header(header, &w->header);
+    if(fwrite(header, 1, sizeof(header), w->file) != sizeof(header)) {
+        prime_table_writer_abandon(w);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+PrimeTableWriter* prime_table_writer_write(PrimeTableWriter* w, uint64_t const* values, size_t count, CaveError* err) {
+    uint32_t width = w->header.element_width;
+    uint64_t max = width == 8 ? UINT64_MAX : UINT32_MAX;
+    unsigned char chunk[ENCODE_CHUNK * 8];
+
+    for(size_t start = 0; start < count; start += ENCODE_CHUNK) {
+        size_t n = count - start < ENCODE_CHUNK ? count - start : ENCODE_CHUNK;
+        for(size_t i = 0; i < n; i++) {
+            uint64_t value = values[start + i];
+            if(value < w->last || value >= w->header.bound || value > max) {
+                *err = CAVE_DATA_ERROR;
+                return NULL;
+            }
+            store_le(chunk + i * width, value, width);
+            w->header.checksum = prime_table_checksum_step(w->header.checksum, value);
+            w->last = value;
+        }
+        if(fwrite(chunk, width, n, w->file) != n) {
+            *err = CAVE_FILE_ERROR;
+            return NULL;
+        }
+        w->header.count += n;
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+void prime_table_writer_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    prime_table_writer_write(closure_data, primes, count, err);
+}
+
+PrimeTableWriter* prime_table_writer_flush(PrimeTableWriter* w, CaveError* err) {
+    if(fflush(w->file) != 0 || fsync(fileno(w->file)) != 0) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+PrimeTableWriter* prime_table_writer_resume(PrimeTableWriter* w, char const* path, PrimeTableHeader const* header,
+                                            uint64_t last, CaveError* err) {
+    if(w == NULL || path == NULL || header == NULL || (header->element_width != 4 && header->element_width != 8)) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(!init_paths(w, path)) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    w->file = fopen(w->tmp_path, "r+b");
+    if(w->file == NULL) {
+        free_paths(w);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    w->header = *header;
+    w->last = last;
+
+    //the header at the front is the placeholder written on open, so it should match apart from the count and
+    //checksum. Anything past the values the header accounts for was written after it was taken.
+    unsigned char bytes[PRIME_TABLE_HEADER_BYTES];
+    PrimeTableHeader on_disk;
+    struct stat st;
+    off_t length = (off_t)(PRIME_TABLE_HEADER_BYTES + header->count * header->element_width);
+    if(fread(bytes, 1, sizeof(bytes), w->file) != sizeof(bytes) || !decode_header(bytes, &on_disk)
+       || on_disk.bound != header->bound || on_disk.element_width != header->element_width
+       || fstat(fileno(w->file), &st) != 0 || st.st_size < length) {
+        fclose(w->file);
+        free_paths(w);
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(ftruncate(fileno(w->file), length) != 0 || fseek(w->file, 0, SEEK_END) != 0) {
+        fclose(w->file);
+        free_paths(w);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+bool prime_table_writer_close(PrimeTableWriter* w, CaveError* err) {
+    unsigned char header[PRIME_TABLE_HEADER_BYTES];
+    encode_header(header, &w->header);
+    bool ok = fseek(w->file, 0, SEEK_SET) == 0
+              && fwrite(header, 1, sizeof(header), w->file) == sizeof(header)
+              && fflush(w->file) == 0;
+    //the rename is only a promise of a complete table if everything it renames is on disk first.
+    ok = ok && fsync(fileno(w->file)) == 0;
+    ok = fclose(w->file) == 0 && ok;
+    w->file = NULL;
+    ok = ok && rename(w->tmp_path, w->path) == 0;
+    if(!ok) {
+        remove(w->tmp_path);
+    }
+    free_paths(w);
+    *err = ok ? CAVE_NO_ERROR : CAVE_FILE_ERROR;
+    return ok;
+}
+
+void prime_table_writer_abandon(PrimeTableWriter* w) {
+    if(w == NULL) {
+        return;
+    }
+    if(w->file != NULL) {
+        fclose(w->file);
+        w->file = NULL;
+    }
+    if(w->tmp_path != NULL) {
+        remove(w->tmp_path);
+    }
+    free_paths(w);
+}
+
+bool prime_table_write(char const* path, CaveVec const* values, uint64_t bound, double growth, CaveError* err) {
+    if(values == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    PrimeTableWriter w;
+    if(prime_table_writer_open(&w, path, bound, growth, prime_table_width_for(bound), err) == NULL) {
+        return false;
+    }
+    if(prime_table_writer_write(&w, values->data, values->len, err) == NULL) {
+        prime_table_writer_abandon(&w);
+        return false;
+    }
+    return prime_table_writer_close(&w, err);
+}
+
+PrimeTable* prime_table_open(PrimeTable* t, char const* path, bool verify, CaveError* err) {
+    if(t == NULL || path == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+    if((uint64_t)st.st_size < PRIME_TABLE_HEADER_BYTES) {
+        close(fd);
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    t->map_bytes = (size_t)st.st_size;
+    t->map = mmap(NULL, t->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    //the mapping keeps the file alive on its own.
+    close(fd);
+    if(t->map == MAP_FAILED) {
+        t->map = NULL;
+        *err = CAVE_FILE_ERROR;
+        return NULL;
+    }
+
+    unsigned char const* bytes = t->map;
+    PrimeTableHeader* h = &t->header;
+    bool valid = decode_header(bytes, h)
+                 && h->version == PRIME_TABLE_VERSION
+                 && (h->element_width == 4 || h->element_width == 8)
+                 && h->count <= (t->map_bytes - PRIME_TABLE_HEADER_BYTES) / h->element_width
+                 && PRIME_TABLE_HEADER_BYTES + h->count * h->element_width == t->map_bytes;
+    t->data = bytes + PRIME_TABLE_HEADER_BYTES;
+
+    if(valid && verify) {
+        uint64_t checksum = PRIME_TABLE_CHECKSUM_SEED;
+        for(uint64_t i = 0; i < h->count; i++) {
+            checksum = prime_table_checksum_step(checksum, prime_table_at(t, i));
+        }
+        valid = checksum == h->checksum;
+    }
+    if(!valid) {
+        prime_table_close(t);
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return t;
+}
+
+void prime_table_close(PrimeTable* t) {
+    if(t == NULL || t->map == NULL) {
+        return;
+    }
+    munmap(t->map, t->map_bytes);
+    t->map = NULL;
+    t->data = NULL;
+    t->map_bytes = 0;
+}
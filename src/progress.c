@@ -0,0 +1,154 @@
+#include "include/progress.h"
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+//the resident set size, in bytes. Where there's no way to get the current one, the peak.
+static uint64_t resident_bytes(void) {
+#ifdef __linux__
+    unsigned long long pages = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if(f != NULL) {
+        if(fscanf(f, "%*s %llu", &pages) != 1) {
+            pages = 0;
+        }
+        fclose(f);
+    }
+    return (uint64_t)pages * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+//prints value with a k, M or G on the end, to 3 significant figures.
+static void fprint_si(FILE* stream, double value, char const* unit) {
+    char const* prefixes = " kMGTP";
+    while(value >= 999.5 && prefixes[1] != '\0') {
+        value /= 1000;
+        prefixes++;
+    }
+    int decimals = value < 9.995 ? 2 : value < 99.95 ? 1 : 0;
+    if(*prefixes == ' ') {
+        fprintf(stream, "%.*f%s", decimals, value, unit);
+    } else {
+        fprintf(stream, "%.*f%c%s", decimals, value, *prefixes, unit);
+    }
+}
+
+static void print_line(ProgressReporter* r, uint64_t position, uint64_t count) {
+    double elapsed = monotonic_seconds() - r->start_time;
+    double numbers = (double)(position - r->start_position);
+    double primes = (double)(count - r->start_count);
+    double numbers_per_second = elapsed > 0 ? numbers / elapsed : 0;
+    double primes_per_second = elapsed > 0 ? primes / elapsed : 0;
+
+    fprintf(r->stream, "progress: %.1f%% (%" PRIu64 "), %" PRIu64 " primes, ",
+            r->bound > 0 ? 100.0 * (double)position / (double)r->bound : 100.0, position, count);
+    fprint_si(r->stream, numbers_per_second, " numbers/s, ");
+    fprint_si(r->stream, primes_per_second, " primes/s, eta ");
+    if(numbers_per_second > 0) {
+        uint64_t eta = (uint64_t)((double)(r->bound - position) / numbers_per_second);
+        fprintf(r->stream, "%" PRIu64 ":%02u:%02u", eta / 3600, (unsigned)(eta / 60 % 60), (unsigned)(eta % 60));
+    } else {
+        fprintf(r->stream, "unknown");
+    }
+    fprintf(r->stream, ", rss ");
+    fprint_si(r->stream, (double)resident_bytes(), "B\n");
+    fflush(r->stream);
+}
+
+static void* reporter_main(void* arg) {
+    ProgressReporter* r = arg;
+    pthread_mutex_lock(&r->lock);
+    while(!r->stopping) {
+        //the deadline is on the realtime clock, since that's the only one every pthreads can wait on.
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        time_t whole = (time_t)r->interval;
+        deadline.tv_sec += whole;
+        deadline.tv_nsec += (long)((r->interval - (double)whole) * 1e9);
+        if(deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        while(!r->stopping && pthread_cond_timedwait(&r->wake, &r->lock, &deadline) == 0) {}
+        if(r->stopping) {
+            break;
+        }
+        pthread_mutex_unlock(&r->lock);
+        print_line(r, atomic_load_explicit(&r->position, memory_order_relaxed),
+                   atomic_load_explicit(&r->count, memory_order_relaxed));
+        pthread_mutex_lock(&r->lock);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+ProgressReporter* progress_reporter_start(ProgressReporter* r, FILE* stream, uint64_t bound, double interval,
+                                          uint64_t position, uint64_t count,
+                                          PRIME_BATCH_CLOSURE next, void* next_data, CaveError* err) {
+    if(r == NULL || stream == NULL || next == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    r->next = next;
+    r->next_data = next_data;
+    r->stream = stream;
+    r->bound = bound;
+    r->interval = interval;
+    r->start_position = position;
+    r->start_count = count;
+    r->start_time = monotonic_seconds();
+    atomic_init(&r->position, position);
+    atomic_init(&r->count, count);
+    r->stopping = false;
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->wake, NULL);
+    if(pthread_create(&r->thread, NULL, reporter_main, r) != 0) {
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->wake);
+        *err = CAVE_UNKNOWN_ERROR;
+        return NULL;
+    }
+    *err = CAVE_NO_ERROR;
+    return r;
+}
+
+void progress_reporter_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    ProgressReporter* r = closure_data;
+    r->next(primes, count, r->next_data, err);
+    if(count == 0) {
+        return;
+    }
+    //only this thread ever writes these, and the reporter only needs them to be roughly current, so relaxed
+    //stores are enough. They're plain stores on any machine this runs on, so there's no cost to the batch.
+    uint64_t seen = atomic_load_explicit(&r->count, memory_order_relaxed);
+    atomic_store_explicit(&r->count, seen + count, memory_order_relaxed);
+    atomic_store_explicit(&r->position, primes[count - 1] + 1, memory_order_relaxed);
+}
+
+void progress_reporter_stop(ProgressReporter* r, uint64_t position) {
+    pthread_mutex_lock(&r->lock);
+    r->stopping = true;
+    pthread_cond_broadcast(&r->wake);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->wake);
+    print_line(r, position, atomic_load_explicit(&r->count, memory_order_relaxed));
+}
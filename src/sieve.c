@@ -0,0 +1,278 @@
+#include "include/sieve.h"
+#include <stdlib.h>
+#include <string.h>
+
+//the number of primes sieve_cursor_next() gathers up before pushing them.
+#define SIEVE_PUSH_BUFFER (512)
+
+//the first multiple of `p` at or after `low` that needs crossing off, as an index into a segment starting at `low`.
+//multiples below p*p have a smaller prime factor, so they are crossed off by a smaller prime. Likewise, p*k where
+//k is not a candidate of the wheel is never read, so that's skipped too.
+static SieveMultiple first_multiple(uint64_t p, uint64_t low, Wheel const* wheel) {
+    uint64_t k;
+    //p * k - low. Kept relative to low so that nothing here can overflow.
+    uint64_t offset;
+    if(p * p > low) {
+        k = p;
+        offset = p * p - low;
+    } else {
+        uint64_t rem = low % p;
+        k = low / p + (rem != 0);
+        offset = rem == 0 ? 0 : p - rem;
+    }
+
+    uint32_t k_residue = (uint32_t)(k % wheel->modulus);
+    uint32_t wheel_index = wheel->next_residue[k_residue];
+    uint64_t step;
+    if(wheel_index == wheel->residue_count) {
+        wheel_index = 0;
+        step = wheel->modulus - k_residue + wheel->residues[0];
+    } else {
+        step = wheel->residues[wheel_index] - k_residue;
+    }
+    offset += step * p;
+
+    //low is even and p * k is odd, so offset is odd.
+    SieveMultiple m = {(offset - 1) / 2, wheel_index};
+    return m;
+}
+
+void prime_batch_push(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    cave_vec_push_n(closure_data, primes, count, err);
+}
+
+Sieve* sieve_init(Sieve* s, uint64_t upperbound, size_t segment_bytes, WheelKind wheel, CaveError* err) {
+    if(s == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    s->upperbound = upperbound;
+    s->segment_bytes = segment_bytes == 0 ? SIEVE_DEFAULT_SEGMENT_BYTES : segment_bytes;
+    wheel_init(&s->wheel, wheel);
+    uint64_t largest_wheel_prime = s->wheel.primes[s->wheel.prime_count - 1];
+
+    if(base_primes_init(&s->base, upperbound, err) == NULL) {
+        return NULL;
+    }
+    uint32_t const* base = base_primes_data(&s->base);
+    s->first_sieving_prime = 0;
+    while(s->first_sieving_prime < s->base.primes.len && base[s->first_sieving_prime] <= largest_wheel_prime) {
+        s->first_sieving_prime++;
+    }
+
+    *err = CAVE_NO_ERROR;
+    return s;
+}
+
+void sieve_release(Sieve* s) {
+    if(s == NULL) {
+        return;
+    }
+    base_primes_release(&s->base);
+}
+
+SieveCursor* sieve_cursor_init(SieveCursor* c, Sieve const* s, uint64_t low, uint64_t high, CaveError* err) {
+    if(c == NULL || s == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    c->sieve = s;
+    c->low = low & ~(uint64_t)1;
+    c->high = high < s->upperbound ? high : s->upperbound;
+    c->active = 0;
+
+    c->segment = malloc(s->segment_bytes);
+    if(c->segment == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    size_t sieving_count = s->base.primes.len - s->first_sieving_prime;
+    if(cave_vec_init(&c->multiples, sizeof(SieveMultiple), sieving_count, err) == NULL) {
+        free(c->segment);
+        return NULL;
+    }
+
+    *err = CAVE_NO_ERROR;
+    return c;
+}
+
+void sieve_cursor_seek(SieveCursor* c, uint64_t low, uint64_t high) {
+    c->low = low & ~(uint64_t)1;
+    c->high = high < c->sieve->upperbound ? high : c->sieve->upperbound;
+    //the multiples are relative to the old position, so they all have to be worked out again.
+    c->active = 0;
+}
+
+bool sieve_cursor_next(SieveCursor* c, CaveVec* primes, CaveError* err) {
+    if(c == NULL || primes == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    *err = CAVE_NO_ERROR;
+    if(c->low >= c->high) {
+        return false;
+    }
+
+    uint64_t low = c->low;
+    uint64_t odd_count = (c->high - low) / 2;
+    size_t n = odd_count < c->sieve->segment_bytes ? (size_t)odd_count : c->sieve->segment_bytes;
+    if(n == 0) {
+        //at most a single even number is left, which can't be prime (2 is taken care of with the wheel's primes).
+        c->low = c->high;
+        return false;
+    }
+    //the last number in this segment is low + 2n - 1.
+    uint64_t segment_last = low + 2 * (uint64_t)n - 1;
+
+    //bring in any base primes whose square falls in this segment. They're sorted, so once one
+    //is too big, the rest are too.
+    Wheel const* wheel = &c->sieve->wheel;
+    uint32_t const* base = base_primes_data(&c->sieve->base) + c->sieve->first_sieving_prime;
+    size_t base_len = c->sieve->base.primes.len - c->sieve->first_sieving_prime;
+    SieveMultiple* multiples = c->multiples.data;
+    while(c->active < base_len && base[c->active] <= segment_last / base[c->active]) {
+        multiples[c->active] = first_multiple(base[c->active], low, wheel);
+        c->active++;
+    }
+    c->multiples.len = c->active;
+
+    uint8_t* segment = c->segment;
+    memset(segment, 1, n);
+
+    for(size_t i = 0; i < c->active; i++) {
+        uint64_t p = base[i];
+        uint64_t j = multiples[i].index;
+        uint32_t w = multiples[i].wheel_index;
+        //going from p*k to p*k' where k' is the next candidate after k moves (k' - k) * p numbers,
+        //which is (k' - k) * p / 2 bytes.
+        while(j < n) {
+            segment[j] = 0;
+            j += p * (wheel->gaps[w] / 2);
+            w++;
+            if(w == wheel->residue_count) {
+                w = 0;
+            }
+        }
+        multiples[i].index = j - n;
+        multiples[i].wheel_index = w;
+    }
+
+    WheelIter it;
+    if(low == 0) {
+        //the primes the wheel is built from aren't candidates, so they'd never be read out of the segment.
+        for(uint32_t i = 0; i < wheel->prime_count && wheel->primes[i] < c->high; i++) {
+            uint64_t prime = wheel->primes[i];
+            if(cave_vec_push(primes, &prime, err) == NULL) {
+                return false;
+            }
+        }
+        //1 is a candidate, but isn't prime.
+        wheel_iter_init(&it, wheel, 2);
+    } else {
+        wheel_iter_init(&it, wheel, low);
+    }
+    //the primes are gathered up on the stack and pushed a buffer at a time, rather than one push apiece.
+    uint64_t found[SIEVE_PUSH_BUFFER];
+    size_t found_len = 0;
+    for(uint64_t candidate = it.value; candidate <= segment_last; candidate = wheel_iter_next(&it)) {
+        found[found_len] = candidate;
+        found_len += segment[(candidate - low) / 2];
+        if(found_len == SIEVE_PUSH_BUFFER) {
+            if(cave_vec_push_n(primes, found, found_len, err) == NULL) {
+                return false;
+            }
+            found_len = 0;
+        }
+    }
+    if(cave_vec_push_n(primes, found, found_len, err) == NULL) {
+        return false;
+    }
+
+    c->low = segment_last + 1;
+    return true;
+}
+
+void sieve_cursor_release(SieveCursor* c) {
+    if(c == NULL) {
+        return;
+    }
+    free(c->segment);
+    c->segment = NULL;
+    cave_vec_release(&c->multiples);
+}
+
+CaveVec* sieve_primes_below(CaveVec* primes, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                            CaveError* err) {
+    if(primes == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    Sieve sieve;
+    if(sieve_init(&sieve, upperbound, segment_bytes, wheel, err) == NULL) {
+        return NULL;
+    }
+    SieveCursor cursor;
+    if(sieve_cursor_init(&cursor, &sieve, 0, upperbound, err) == NULL) {
+        sieve_release(&sieve);
+        return NULL;
+    }
+
+    while(sieve_cursor_next(&cursor, primes, err)) {}
+
+    sieve_cursor_release(&cursor);
+    sieve_release(&sieve);
+    return *err == CAVE_NO_ERROR ? primes : NULL;
+}
+
+bool sieve_foreach_batch(uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                         PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err) {
+    return sieve_foreach_batch_from(0, upperbound, segment_bytes, wheel, fn, closure_data, err);
+}
+
+static uint64_t resume_low(Wheel const* wheel, uint64_t start) {
+    //the wheel's own primes are only pushed by a segment starting at 0, so a start at or before any of them
+    //has to begin from 0, and have the primes before it trimmed off.
+    return start <= wheel->primes[wheel->prime_count - 1] ? 0 : start;
+}
+
+bool sieve_foreach_batch_from(uint64_t start, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                              PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err) {
+    if(fn == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    Sieve sieve;
+    if(sieve_init(&sieve, upperbound, segment_bytes, wheel, err) == NULL) {
+        return false;
+    }
+    SieveCursor cursor;
+    if(sieve_cursor_init(&cursor, &sieve, resume_low(&sieve.wheel, start), upperbound, err) == NULL) {
+        sieve_release(&sieve);
+        return false;
+    }
+    CaveVec batch;
+    if(cave_vec_init(&batch, sizeof(uint64_t), 0, err) == NULL) {
+        sieve_cursor_release(&cursor);
+        sieve_release(&sieve);
+        return false;
+    }
+
+    while(sieve_cursor_next(&cursor, &batch, err)) {
+        //the segment starts at or before start, so anything before it has to be skipped.
+        uint64_t const* primes = batch.data;
+        size_t skip = 0;
+        while(skip < batch.len && primes[skip] < start) {
+            skip++;
+        }
+        fn(primes + skip, batch.len - skip, closure_data, err);
+        if(*err != CAVE_NO_ERROR) {
+            break;
+        }
+        cave_vec_clear(&batch, err);
+    }
+
+    cave_vec_release(&batch);
+    sieve_cursor_release(&cursor);
+    sieve_release(&sieve);
+    return *err == CAVE_NO_ERROR;
+}
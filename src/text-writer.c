@@ -0,0 +1,182 @@
+#include "include/text-writer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+//the longest a number gets written: 20 digits and " , ".
+#define MAX_ENTRY_BYTES (23)
+
+static char const DIGIT_PAIRS[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static uint32_t const POWERS_OF_10[10] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+//the number of decimal digits in v, which is less than 10^8. 1233 / 4096 is just over log10(2), so the
+//estimate from the bit length is either right or one short. The | 1 makes 0 come out as 1 digit, and changes
+//nothing else.
+static inline unsigned decimal_digits(uint32_t v) {
+    v |= 1;
+    unsigned bits = 32 - (unsigned)__builtin_clz(v);
+    unsigned digits = (bits * 1233) >> 12;
+    return digits + (v >= POWERS_OF_10[digits]);
+}
+
+//writes v, which is less than 10^8, at out in as many digits as it takes, and returns the end of it. Digits
+//come off the bottom two at a time, so it writes from the end backwards.
+static inline char* write_short(char* out, uint32_t v) {
+    char* end = out + decimal_digits(v);
+    char* p = end;
+    while(v >= 100) {
+        uint32_t q = v / 100;
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + 2 * (v - q * 100), 2);
+        v = q;
+    }
+    if(v >= 10) {
+        memcpy(p - 2, DIGIT_PAIRS + 2 * v, 2);
+    } else {
+        p[-1] = (char)('0' + v);
+    }
+    return end;
+}
+
+//writes v, which is less than 10^8, at out as exactly 8 digits, with leading zeros.
+static inline char* write_8_digits(char* out, uint32_t v) {
+    uint32_t high = v / 10000;
+    uint32_t low = v - high * 10000;
+    memcpy(out, DIGIT_PAIRS + 2 * (high / 100), 2);
+    memcpy(out + 2, DIGIT_PAIRS + 2 * (high % 100), 2);
+    memcpy(out + 4, DIGIT_PAIRS + 2 * (low / 100), 2);
+    memcpy(out + 6, DIGIT_PAIRS + 2 * (low % 100), 2);
+    return out + 8;
+}
+
+//writes v in decimal at out, and returns the end of it. It's split into pieces of 8 digits, so the rest of
+//the work can be done in 32 bits, where dividing (by a constant, so really multiplying) is cheaper.
+static inline char* write_uint64(char* out, uint64_t v) {
+    if(v < 100000000) {
+        return write_short(out, (uint32_t)v);
+    }
+    uint64_t high = v / 100000000;
+    uint32_t low = (uint32_t)(v - high * 100000000);
+    if(high < 100000000) {
+        out = write_short(out, (uint32_t)high);
+    } else {
+        uint64_t top = high / 100000000;
+        out = write_short(out, (uint32_t)top);
+        out = write_8_digits(out, (uint32_t)(high - top * 100000000));
+    }
+    return write_8_digits(out, low);
+}
+
+TextWriter* text_writer_init(TextWriter* w, int fd, CaveError* err) {
+    if(w == NULL || fd < 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    w->buffer = malloc(TEXT_WRITER_BUFFER_BYTES);
+    if(w->buffer == NULL) {
+        *err = CAVE_INSUFFICIENT_MEMORY_ERROR;
+        return NULL;
+    }
+    w->fd = fd;
+    w->len = 0;
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+TextWriter* text_writer_flush(TextWriter* w, CaveError* err) {
+    size_t done = 0;
+    while(done < w->len) {
+        ssize_t n = write(w->fd, w->buffer + done, w->len - done);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            *err = CAVE_FILE_ERROR;
+            return NULL;
+        }
+        done += (size_t)n;
+    }
+    w->len = 0;
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+TextWriter* text_writer_uint64s(TextWriter* w, uint64_t const* values, size_t count, CaveError* err) {
+    for(size_t i = 0; i < count; i++) {
+        if(TEXT_WRITER_BUFFER_BYTES - w->len < MAX_ENTRY_BYTES && text_writer_flush(w, err) == NULL) {
+            return NULL;
+        }
+        char* end = write_uint64(w->buffer + w->len, values[i]);
+        memcpy(end, " , ", 3);
+        w->len = (size_t)(end + 3 - w->buffer);
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+TextWriter* text_writer_str(TextWriter* w, char const* s, CaveError* err) {
+    size_t len = strlen(s);
+    while(len > 0) {
+        if(w->len == TEXT_WRITER_BUFFER_BYTES && text_writer_flush(w, err) == NULL) {
+            return NULL;
+        }
+        size_t n = TEXT_WRITER_BUFFER_BYTES - w->len < len ? TEXT_WRITER_BUFFER_BYTES - w->len : len;
+        memcpy(w->buffer + w->len, s, n);
+        w->len += n;
+        s += n;
+        len -= n;
+    }
+    *err = CAVE_NO_ERROR;
+    return w;
+}
+
+void text_writer_consume(uint64_t const* primes, size_t count, void* closure_data, CaveError* err) {
+    text_writer_uint64s(closure_data, primes, count, err);
+}
+
+bool text_writer_release(TextWriter* w, CaveError* err) {
+    if(w == NULL || w->buffer == NULL) {
+        *err = CAVE_NO_ERROR;
+        return true;
+    }
+    bool ok = text_writer_flush(w, err) != NULL;
+    free(w->buffer);
+    w->buffer = NULL;
+    return ok;
+}
+
+bool fprint_vec_of_uint64(CaveVec const* v, FILE* stream, CaveError* err) {
+    if(v == NULL || stream == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    //a great deal faster than fprintf'ing the numbers one at a time. Whatever stream already has buffered
+    //has to go out first.
+    fflush(stream);
+    TextWriter writer;
+    if(text_writer_init(&writer, fileno(stream), err) == NULL) {
+        return false;
+    }
+    if(text_writer_uint64s(&writer, v->data, v->len, err) != NULL) {
+        text_writer_str(&writer, "\n", err);
+    }
+    CaveError release_err;
+    if(!text_writer_release(&writer, &release_err) && *err == CAVE_NO_ERROR) {
+        *err = release_err;
+    }
+    return *err == CAVE_NO_ERROR;
+}
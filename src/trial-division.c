@@ -0,0 +1,129 @@
+#include "include/trial-division.h"
+#include "include/trial-kernel.h"
+#include "include/typed-vec.h"
+
+//num is the number we are checking to see if it is prime.
+//base is a table of every prime up to at least sqrt(num), with its divisors worked out.
+bool check_if_prime(uint64_t num, BasePrimes const* base, size_t skip) {
+    uint32_t const* primes = base_primes_data(base);
+    BaseDivisor const* divisors = base->divisors.data;
+    size_t i = skip;
+    //2 has no inverse mod 2^64, so it gets checked the old fashioned way.
+    if(i == 0 && base->primes.len > 0) {
+        if(num % 2 == 0) {
+            return num == 2;
+        }
+        i = 1;
+    }
+    for(; i < base->primes.len; i++) {
+        uint64_t prime_i = primes[i];
+        //never need to check past sqrt(num). However, casting num to floating point and calling
+        //sqrt() on it introduces floating point error. I don't know enough about floating point error to
+        //calculate when the error would be off by 1 or more, but if any prime is missed, then the whole thing
+        //will start getting filled up with non-prime numbers. So I check this way instead. I'm guessing
+        //it's a similar speed.
+        if(prime_i * prime_i > num) {
+            return true;
+        }
+        //the same as num % prime_i == 0, but a multiply and a compare instead of a division.
+        if(base_divisor_divides(divisors[i], num)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool trial_division_foreach_batch(uint64_t upperbound, WheelKind wheel_kind,
+                                  PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err) {
+    return trial_division_foreach_batch_from(0, upperbound, wheel_kind, fn, closure_data, err);
+}
+
+bool trial_division_foreach_batch_from(uint64_t start, uint64_t upperbound, WheelKind wheel_kind,
+                                       PRIME_BATCH_CLOSURE fn, void* closure_data, CaveError* err) {
+    if(fn == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return false;
+    }
+    BasePrimes base;
+    if(base_primes_init(&base, upperbound, err) == NULL) {
+        return false;
+    }
+    if(base_primes_init_divisors(&base, err) == NULL) {
+        base_primes_release(&base);
+        return false;
+    }
+    Wheel wheel;
+    wheel_init(&wheel, wheel_kind);
+    TrialKernel kernel;
+    if(trial_kernel_init(&kernel, &base, wheel.prime_count, upperbound, TRIAL_KERNEL_AUTO, err) == NULL) {
+        base_primes_release(&base);
+        return false;
+    }
+    U64Vec batch;
+    if(u64_vec_init(&batch, TRIAL_DIVISION_BATCH_SIZE, err) == NULL) {
+        trial_kernel_release(&kernel);
+        base_primes_release(&base);
+        return false;
+    }
+
+    //the wheel's own primes are the only ones that aren't candidates.
+    for(uint32_t i = 0; i < wheel.prime_count && wheel.primes[i] < upperbound; i++) {
+        uint64_t p = wheel.primes[i];
+        if(p >= start) {
+            u64_vec_push(&batch, p, err);
+        }
+    }
+
+    //candidates are tested a block at a time, so the kernel can test several at once.
+    uint64_t block[TRIAL_KERNEL_BLOCK_SIZE];
+    size_t block_len = 0;
+    uint64_t primes[3 * TRIAL_KERNEL_BLOCK_SIZE];
+    WheelIter it;
+    //starting from 2 skips 1, which is a candidate but isn't prime.
+    wheel_iter_init(&it, &wheel, start > 2 ? start : 2);
+    uint64_t candidate = it.value;
+    while(*err == CAVE_NO_ERROR && (candidate < upperbound || block_len > 0)) {
+        if(candidate < upperbound && block_len < TRIAL_KERNEL_BLOCK_SIZE) {
+            block[block_len++] = candidate;
+            candidate = wheel_iter_next(&it);
+            continue;
+        }
+        size_t found = trial_kernel_filter(&kernel, block, block_len, primes);
+        block_len = 0;
+        if(candidate >= upperbound) {
+            found += trial_kernel_finish(&kernel, primes + found);
+        }
+        //whatever doesn't fit in this batch goes in the next.
+        for(size_t j = 0; j < found && *err == CAVE_NO_ERROR;) {
+            size_t room = TRIAL_DIVISION_BATCH_SIZE - batch.len;
+            size_t n = found - j < room ? found - j : room;
+            if(u64_vec_push_n(&batch, primes + j, n, err) != NULL && batch.len == TRIAL_DIVISION_BATCH_SIZE) {
+                fn(batch.data, batch.len, closure_data, err);
+                if(*err != CAVE_NO_ERROR) {
+                    break;
+                }
+                u64_vec_clear(&batch);
+            }
+            j += n;
+        }
+    }
+    if(*err == CAVE_NO_ERROR && batch.len > 0) {
+        fn(batch.data, batch.len, closure_data, err);
+    }
+
+    u64_vec_release(&batch);
+    trial_kernel_release(&kernel);
+    base_primes_release(&base);
+    return *err == CAVE_NO_ERROR;
+}
+
+CaveVec* trial_division_primes_below(CaveVec* primes, uint64_t upperbound, WheelKind wheel, CaveError* err) {
+    if(primes == NULL || primes->len != 0) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(!trial_division_foreach_batch(upperbound, wheel, prime_batch_push, primes, err)) {
+        return NULL;
+    }
+    return primes;
+}
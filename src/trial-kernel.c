@@ -0,0 +1,232 @@
+#include "include/trial-kernel.h"
+#include "include/trial-division.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TRIAL_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+bool trial_kernel_supported(TrialKernelKind kind) {
+    switch(kind) {
+        case TRIAL_KERNEL_AUTO:
+        case TRIAL_KERNEL_SCALAR:
+            return true;
+#ifdef TRIAL_KERNEL_X86
+        case TRIAL_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case TRIAL_KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+char const* trial_kernel_name(TrialKernelKind kind) {
+    switch(kind) {
+        case TRIAL_KERNEL_AUTO:
+            return "auto";
+        case TRIAL_KERNEL_SCALAR:
+            return "scalar";
+        case TRIAL_KERNEL_AVX2:
+            return "avx2";
+        case TRIAL_KERNEL_AVX512:
+            return "avx512";
+        default:
+            return "unknown";
+    }
+}
+
+TrialKernel* trial_kernel_init(TrialKernel* k, BasePrimes const* base, size_t skip, uint64_t upperbound,
+                               TrialKernelKind kind, CaveError* err) {
+    if(k == NULL || base == NULL) {
+        *err = CAVE_DATA_ERROR;
+        return NULL;
+    }
+    if(kind == TRIAL_KERNEL_AUTO) {
+        kind = trial_kernel_supported(TRIAL_KERNEL_AVX512) ? TRIAL_KERNEL_AVX512
+             : trial_kernel_supported(TRIAL_KERNEL_AVX2) ? TRIAL_KERNEL_AVX2
+             : TRIAL_KERNEL_SCALAR;
+    }
+    if(!trial_kernel_supported(kind) || upperbound > TRIAL_KERNEL_MAX_VALUE) {
+        kind = TRIAL_KERNEL_SCALAR;
+    }
+    k->kind = kind;
+    k->base = base;
+    k->skip = skip;
+    k->split = skip + TRIAL_KERNEL_FIRST_DIVISORS < base->primes.len ? skip + TRIAL_KERNEL_FIRST_DIVISORS
+                                                                      : base->primes.len;
+    k->pending_len = 0;
+
+    size_t count = kind == TRIAL_KERNEL_SCALAR ? 0 : base->primes.len;
+    if(cave_vec_init(&k->divisors, sizeof(TrialDivisor), count > 0 ? count : 1, err) == NULL) {
+        return NULL;
+    }
+    uint32_t const* primes = base_primes_data(base);
+    for(size_t i = 0; i < count; i++) {
+        TrialDivisor d = {(double)primes[i], 1.0 / (double)primes[i]};
+        cave_vec_push(&k->divisors, &d, err);
+    }
+    *err = CAVE_NO_ERROR;
+    return k;
+}
+
+void trial_kernel_release(TrialKernel* k) {
+    if(k == NULL) {
+        return;
+    }
+    cave_vec_release(&k->divisors);
+}
+
+#ifdef TRIAL_KERNEL_X86
+
+//adding and then subtracting 1.5 * 2^52 rounds anything of smaller magnitude to the nearest integer, and
+//is cheaper than a round instruction. With an fma it also skips rounding n * (1/p) before that.
+#define ROUNDING_MAGIC (6755399441055744.0)
+
+//each kernel tests a full block of candidates against the divisors from `first` up to `end`, stopping early once
+//every candidate is known composite or the divisors pass the square root of the biggest, `max`. It returns a
+//mask of the composites. Some divisors are past the square root of the smaller candidates, but a divisor past
+//the square root that divides a candidate still proves it composite, unless it is the candidate itself, which
+//the caller rules out.
+
+__attribute__((target("avx2,fma")))
+static uint32_t composites_avx2(TrialKernel const* k, double const* n, size_t first, size_t end, uint64_t max) {
+    __m256d const zero = _mm256_setzero_pd();
+    __m256d const magic = _mm256_set1_pd(ROUNDING_MAGIC);
+    __m256d n0 = _mm256_loadu_pd(n), n1 = _mm256_loadu_pd(n + 4);
+    __m256d n2 = _mm256_loadu_pd(n + 8), n3 = _mm256_loadu_pd(n + 12);
+    __m256d c0 = zero, c1 = zero, c2 = zero, c3 = zero;
+
+    uint32_t const* primes = base_primes_data(k->base);
+    TrialDivisor const* divisors = k->divisors.data;
+    for(size_t i = first; i < end && (uint64_t)primes[i] * primes[i] <= max; i++) {
+        __m256d p = _mm256_broadcast_sd(&divisors[i].prime);
+        __m256d r = _mm256_broadcast_sd(&divisors[i].reciprocal);
+        //the four quarters are independent, so they all go through the pipeline together.
+        __m256d q0 = _mm256_sub_pd(_mm256_fmadd_pd(n0, r, magic), magic);
+        __m256d q1 = _mm256_sub_pd(_mm256_fmadd_pd(n1, r, magic), magic);
+        __m256d q2 = _mm256_sub_pd(_mm256_fmadd_pd(n2, r, magic), magic);
+        __m256d q3 = _mm256_sub_pd(_mm256_fmadd_pd(n3, r, magic), magic);
+        c0 = _mm256_or_pd(c0, _mm256_cmp_pd(_mm256_fnmadd_pd(q0, p, n0), zero, _CMP_EQ_OQ));
+        c1 = _mm256_or_pd(c1, _mm256_cmp_pd(_mm256_fnmadd_pd(q1, p, n1), zero, _CMP_EQ_OQ));
+        c2 = _mm256_or_pd(c2, _mm256_cmp_pd(_mm256_fnmadd_pd(q2, p, n2), zero, _CMP_EQ_OQ));
+        c3 = _mm256_or_pd(c3, _mm256_cmp_pd(_mm256_fnmadd_pd(q3, p, n3), zero, _CMP_EQ_OQ));
+        if(_mm256_movemask_pd(_mm256_and_pd(_mm256_and_pd(c0, c1), _mm256_and_pd(c2, c3))) == 0xf) {
+            break;
+        }
+    }
+    return (uint32_t)_mm256_movemask_pd(c0) | (uint32_t)_mm256_movemask_pd(c1) << 4
+         | (uint32_t)_mm256_movemask_pd(c2) << 8 | (uint32_t)_mm256_movemask_pd(c3) << 12;
+}
+
+__attribute__((target("avx512f")))
+static uint32_t composites_avx512(TrialKernel const* k, double const* n, size_t first, size_t end, uint64_t max) {
+    __m512d const zero = _mm512_setzero_pd();
+    __m512d const magic = _mm512_set1_pd(ROUNDING_MAGIC);
+    __m512d n0 = _mm512_loadu_pd(n), n1 = _mm512_loadu_pd(n + 8);
+    __m512d n2 = _mm512_loadu_pd(n + 16), n3 = _mm512_loadu_pd(n + 24);
+    __mmask8 c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+
+    uint32_t const* primes = base_primes_data(k->base);
+    TrialDivisor const* divisors = k->divisors.data;
+    for(size_t i = first; i < end && (uint64_t)primes[i] * primes[i] <= max; i++) {
+        __m512d p = _mm512_set1_pd(divisors[i].prime);
+        __m512d r = _mm512_set1_pd(divisors[i].reciprocal);
+        __m512d q0 = _mm512_sub_pd(_mm512_fmadd_pd(n0, r, magic), magic);
+        __m512d q1 = _mm512_sub_pd(_mm512_fmadd_pd(n1, r, magic), magic);
+        __m512d q2 = _mm512_sub_pd(_mm512_fmadd_pd(n2, r, magic), magic);
+        __m512d q3 = _mm512_sub_pd(_mm512_fmadd_pd(n3, r, magic), magic);
+        c0 |= _mm512_cmp_pd_mask(_mm512_fnmadd_pd(q0, p, n0), zero, _CMP_EQ_OQ);
+        c1 |= _mm512_cmp_pd_mask(_mm512_fnmadd_pd(q1, p, n1), zero, _CMP_EQ_OQ);
+        c2 |= _mm512_cmp_pd_mask(_mm512_fnmadd_pd(q2, p, n2), zero, _CMP_EQ_OQ);
+        c3 |= _mm512_cmp_pd_mask(_mm512_fnmadd_pd(q3, p, n3), zero, _CMP_EQ_OQ);
+        if((c0 & c1 & c2 & c3) == 0xff) {
+            break;
+        }
+    }
+    return (uint32_t)c0 | (uint32_t)c1 << 8 | (uint32_t)c2 << 16 | (uint32_t)c3 << 24;
+}
+
+//the composites among the first `count` of `candidates`, against the divisors from `first` up to `end`.
+static uint32_t composites_vector(TrialKernel const* k, uint64_t const* candidates, size_t count,
+                                  size_t first, size_t end) {
+    //a short block is padded out with its last candidate, and the padding ignored after.
+    double n[TRIAL_KERNEL_BLOCK_SIZE];
+    for(size_t i = 0; i < TRIAL_KERNEL_BLOCK_SIZE; i++) {
+        n[i] = (double)candidates[i < count ? i : count - 1];
+    }
+    if(k->kind == TRIAL_KERNEL_AVX512) {
+        return composites_avx512(k, n, first, end, candidates[count - 1]);
+    }
+    //AVX2 has half the registers, with half the lanes in each, so it goes a half block at a time.
+    uint32_t composites = composites_avx2(k, n, first, end, candidates[count < 16 ? count - 1 : 15]);
+    if(count > 16) {
+        composites |= composites_avx2(k, n + 16, first, end, candidates[count - 1]) << 16;
+    }
+    return composites;
+}
+
+//runs the pending candidates through the rest of the divisors, and writes out the primes.
+static size_t test_pending(TrialKernel* k, uint64_t* primes) {
+    if(k->pending_len == 0) {
+        return 0;
+    }
+    uint32_t composites = composites_vector(k, k->pending, k->pending_len, k->split, k->base->primes.len);
+    size_t found = 0;
+    for(size_t i = 0; i < k->pending_len; i++) {
+        if(!(composites >> i & 1)) {
+            primes[found++] = k->pending[i];
+        }
+    }
+    k->pending_len = 0;
+    return found;
+}
+
+#endif
+
+size_t trial_kernel_filter(TrialKernel* k, uint64_t const* candidates, size_t count, uint64_t* primes) {
+    if(count == 0) {
+        return 0;
+    }
+    size_t found = 0;
+
+#ifdef TRIAL_KERNEL_X86
+    //the vector kernels would count a candidate that is itself a base prime as its own multiple. Those are
+    //all right at the start, so they go the scalar way.
+    if(k->kind != TRIAL_KERNEL_SCALAR && candidates[0] > k->base->limit) {
+        //most candidates have a small factor, and the rest are mostly prime and have to be tested all the way
+        //to the square root. Testing them together would leave most lanes idle waiting on the few primes,
+        //so the small divisors go first, and only the survivors are gathered up to go through the rest.
+        uint32_t composites = composites_vector(k, candidates, count, k->skip, k->split);
+        for(size_t i = 0; i < count; i++) {
+            if(composites >> i & 1) {
+                continue;
+            }
+            k->pending[k->pending_len++] = candidates[i];
+            if(k->pending_len == TRIAL_KERNEL_BLOCK_SIZE) {
+                found += test_pending(k, primes + found);
+            }
+        }
+        return found;
+    }
+    found += test_pending(k, primes);
+#endif
+
+    for(size_t i = 0; i < count; i++) {
+        if(check_if_prime(candidates[i], k->base, k->skip)) {
+            primes[found++] = candidates[i];
+        }
+    }
+    return found;
+}
+
+size_t trial_kernel_finish(TrialKernel* k, uint64_t* primes) {
+#ifdef TRIAL_KERNEL_X86
+    return test_pending(k, primes);
+#else
+    (void)k;
+    (void)primes;
+    return 0;
+#endif
+}
@@ -0,0 +1,61 @@
+#include "include/wheel.h"
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while(b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+Wheel* wheel_init(Wheel* w, WheelKind kind) {
+    static uint32_t const wheel_primes[] = {2, 3, 5, 7};
+
+    w->modulus = (uint32_t)kind;
+    w->prime_count = kind == WHEEL_210 ? 4 : 3;
+    for(uint32_t i = 0; i < w->prime_count; i++) {
+        w->primes[i] = wheel_primes[i];
+    }
+
+    w->residue_count = 0;
+    for(uint32_t r = 0; r < w->modulus; r++) {
+        if(gcd_u32(r, w->modulus) == 1) {
+            w->residues[w->residue_count] = (uint8_t)r;
+            w->residue_count++;
+        }
+    }
+    //walking down from the top, `index` is always the first residue at or above r.
+    uint32_t index = w->residue_count;
+    for(uint32_t r = w->modulus; r-- > 0;) {
+        if(index > 0 && w->residues[index - 1] == r) {
+            index--;
+        }
+        w->next_residue[r] = (uint8_t)index;
+    }
+
+    for(uint32_t i = 0; i < w->residue_count; i++) {
+        uint32_t next = i + 1 < w->residue_count ? w->residues[i + 1] : w->modulus + w->residues[0];
+        w->gaps[i] = (uint8_t)(next - w->residues[i]);
+    }
+    return w;
+}
+
+WheelIter* wheel_iter_init(WheelIter* it, Wheel const* w, uint64_t start) {
+    it->wheel = w;
+    uint64_t turn = start / w->modulus;
+    uint32_t index = w->next_residue[start % w->modulus];
+    if(index == w->residue_count) {
+        turn++;
+        index = 0;
+    }
+    it->index = index;
+
+    uint64_t turn_start = turn * w->modulus;
+    if(turn > UINT64_MAX / w->modulus || turn_start > UINT64_MAX - w->residues[index]) {
+        it->value = UINT64_MAX;
+    } else {
+        it->value = turn_start + w->residues[index];
+    }
+    return it;
+}
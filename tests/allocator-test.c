@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include "tests/test.h"
+#include "include/allocator.h"
+#include "include/typed-vec.h"
+
+//The arena and pool, directly and through their CaveAllocators, and a typed vector on each, since that's what
+//they're for.
+
+static bool is_aligned(void const* p) {
+    return (uintptr_t)p % CAVE_ALLOCATOR_ALIGNMENT == 0;
+}
+
+static void test_pool_order(void) {
+    CaveError err;
+    CavePool p;
+    CHECK(cave_pool_init(&p, 24, 4, &err) != NULL);
+    CHECK(p.block_size >= 24 && p.block_size % CAVE_ALLOCATOR_ALIGNMENT == 0);
+    //a fresh pool hands its blocks out in address order.
+    unsigned char* blocks[4];
+    for(size_t i = 0; i < 4; i++) {
+        blocks[i] = cave_pool_alloc(&p);
+        CHECK(blocks[i] != NULL && is_aligned(blocks[i]));
+        CHECK(blocks[i] == p.blocks + i * p.block_size);
+        memset(blocks[i], (int)i + 1, 24);
+    }
+    CHECK(cave_pool_alloc(&p) == NULL);
+    //a block's contents are its own, until it's freed.
+    for(size_t i = 0; i < 4; i++) {
+        CHECK(blocks[i][0] == i + 1 && blocks[i][23] == i + 1);
+    }
+    //the last block freed is the first handed back out.
+    cave_pool_free(&p, blocks[1]);
+    cave_pool_free(&p, blocks[3]);
+    cave_pool_free(&p, NULL);
+    CHECK(cave_pool_alloc(&p) == blocks[3]);
+    CHECK(cave_pool_alloc(&p) == blocks[1]);
+    CHECK(cave_pool_alloc(&p) == NULL);
+    for(size_t i = 0; i < 4; i++) {
+        cave_pool_free(&p, blocks[i]);
+    }
+    for(size_t i = 4; i > 0; i--) {
+        CHECK(cave_pool_alloc(&p) == blocks[i - 1]);
+    }
+    cave_pool_release(&p);
+
+    //blocks smaller than a pointer are made big enough to hold the free list's.
+    CHECK(cave_pool_init(&p, 1, 3, &err) != NULL);
+    CHECK(p.block_size >= sizeof(void*));
+    void* a = cave_pool_alloc(&p);
+    void* b = cave_pool_alloc(&p);
+    CHECK(a != NULL && b != NULL && a != b);
+    cave_pool_free(&p, a);
+    CHECK(cave_pool_alloc(&p) == a);
+    cave_pool_release(&p);
+
+    CHECK(cave_pool_init(&p, 0, 1, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_pool_init(&p, 8, 0, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_pool_init(NULL, 8, 1, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_pool_init(&p, SIZE_MAX / 2, 4, &err) == NULL && err == CAVE_INSUFFICIENT_MEMORY_ERROR);
+}
+
+static void test_pool_allocator(void) {
+    CaveError err;
+    CavePool p;
+    CHECK(cave_pool_init(&p, 64, 2, &err) != NULL);
+    CaveAllocator pool = cave_pool_allocator(&p);
+    CHECK(pool.alloc(pool.context, p.block_size + 1) == NULL);
+    unsigned char* a = pool.alloc(pool.context, 10);
+    CHECK(a != NULL);
+    memset(a, 9, 10);
+    //growing within the block leaves it where it is, and growing past it is refused with the block untouched.
+    CHECK(pool.realloc(pool.context, a, 10, p.block_size) == a);
+    CHECK(pool.realloc(pool.context, a, p.block_size, p.block_size + 1) == NULL);
+    CHECK(a[0] == 9 && a[9] == 9);
+    //a realloc of nothing is an alloc.
+    unsigned char* b = pool.realloc(pool.context, NULL, 0, 16);
+    CHECK(b != NULL && b != a);
+    CHECK(pool.realloc(pool.context, NULL, 0, 16) == NULL);
+    pool.free(pool.context, b, 16);
+    pool.free(pool.context, a, p.block_size);
+    CHECK(pool.alloc(pool.context, 1) == a);
+    cave_pool_release(&p);
+
+    //a vector on a pool grows in place up to the block size, and no further.
+    CHECK(cave_pool_init(&p, 100 * sizeof(uint64_t), 1, &err) != NULL);
+    U64Vec v;
+    CHECK(u64_vec_init_with_allocator(&v, cave_pool_allocator(&p), 4, &err) != NULL);
+    uint64_t* data = v.data;
+    size_t fits = p.block_size / sizeof(uint64_t);
+    for(uint64_t i = 0; i < fits; i++) {
+        CHECK(u64_vec_push(&v, i, &err) != NULL);
+    }
+    CHECK(v.data == data);
+    CHECK(u64_vec_push(&v, fits, &err) == NULL && err == CAVE_INSUFFICIENT_MEMORY_ERROR);
+    CHECK_EQ_U64(v.len, fits);
+    CHECK_EQ_U64(v.data[fits - 1], fits - 1);
+    u64_vec_release(&v);
+    CHECK(cave_pool_alloc(&p) == data);
+    cave_pool_release(&p);
+}
+
+static void test_arena(void) {
+    CaveError err;
+    CaveArena a;
+    CHECK(cave_arena_init(&a, 1000, &err) != NULL);
+    unsigned char* x = cave_arena_alloc(&a, 1);
+    unsigned char* y = cave_arena_alloc(&a, 17);
+    CHECK(x != NULL && y != NULL && is_aligned(x) && is_aligned(y) && y > x);
+    CHECK(cave_arena_alloc(&a, a.capacity) == NULL);
+
+    CaveAllocator arena = cave_arena_allocator(&a);
+    //the latest allocation grows and is freed in place, and anything older moves to grow.
+    memset(y, 5, 17);
+    CHECK(arena.realloc(arena.context, y, 17, 200) == y);
+    size_t used = a.used;
+    unsigned char* moved = arena.realloc(arena.context, x, 1, 64);
+    CHECK(moved != NULL && moved != x && a.used > used);
+    arena.free(arena.context, moved, 64);
+    CHECK_EQ_U64(a.used, used);
+    //freeing anything but the latest allocation gives nothing back.
+    arena.free(arena.context, x, 1);
+    CHECK_EQ_U64(a.used, used);
+    CHECK(arena.realloc(arena.context, y, 200, a.capacity) == NULL);
+    CHECK(y[0] == 5 && y[16] == 5);
+
+    cave_arena_reset(&a);
+    CHECK(cave_arena_alloc(&a, a.capacity) == x);
+    cave_arena_release(&a);
+
+    CHECK(cave_arena_init(&a, 0, &err) == NULL && err == CAVE_DATA_ERROR);
+}
+
+int main(void) {
+    test_pool_order();
+    test_pool_allocator();
+    test_arena();
+    return test_result("allocator");
+}
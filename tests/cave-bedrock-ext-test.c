@@ -0,0 +1,82 @@
+#include "tests/test.h"
+#include "include/cave-bedrock.h"
+
+//The vector operations filtered-primes adds to Cave until it has them (see src/cave-bedrock-ext.c).
+
+static void test_push_n(void) {
+    CaveError err;
+    CaveVec v;
+    cave_vec_init(&v, sizeof(uint64_t), 1, &err);
+    uint64_t values[1000];
+    for(uint64_t i = 0; i < 1000; i++) {
+        values[i] = i * 3;
+    }
+    //pushing nothing, even from nowhere, is fine.
+    CHECK(cave_vec_push_n(&v, NULL, 0, &err) == &v && err == CAVE_NO_ERROR);
+    CHECK_EQ_U64(v.len, 0);
+    //a few at a time, and then enough that the vector has to grow by more than its growth factor at once.
+    CHECK(cave_vec_push_n(&v, values, 3, &err) == &v);
+    CHECK(cave_vec_push_n(&v, values + 3, 997, &err) == &v);
+    CHECK_EQ_U64(v.len, 1000);
+    CHECK(v.capacity >= 1000);
+    CHECK(memcmp(v.data, values, sizeof(values)) == 0);
+
+    CHECK(cave_vec_push_n(&v, NULL, 1, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_push_n(NULL, values, 1, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_push_n(&v, values, SIZE_MAX, &err) == NULL && err == CAVE_INSUFFICIENT_MEMORY_ERROR);
+    CHECK_EQ_U64(v.len, 1000);
+    cave_vec_release(&v);
+}
+
+static void test_append(void) {
+    CaveError err;
+    CaveVec dest;
+    CaveVec src;
+    cave_vec_init(&dest, sizeof(uint64_t), 0, &err);
+    cave_vec_init(&src, sizeof(uint64_t), 0, &err);
+    for(uint64_t i = 0; i < 500; i++) {
+        cave_vec_push(&dest, &i, &err);
+    }
+    for(uint64_t i = 500; i < 2000; i++) {
+        cave_vec_push(&src, &i, &err);
+    }
+    CHECK(cave_vec_append(&dest, &src, &err) == &dest && err == CAVE_NO_ERROR);
+    CHECK_EQ_U64(dest.len, 2000);
+    CHECK_EQ_U64(src.len, 1500);
+    bool in_order = true;
+    for(uint64_t i = 0; i < dest.len; i++) {
+        in_order = in_order && ((uint64_t*)dest.data)[i] == i;
+    }
+    CHECK(in_order);
+
+    //appending an empty vector changes nothing.
+    CaveVec empty;
+    cave_vec_init(&empty, sizeof(uint64_t), 0, &err);
+    CHECK(cave_vec_append(&dest, &empty, &err) == &dest && err == CAVE_NO_ERROR);
+    CHECK_EQ_U64(dest.len, 2000);
+
+    //a vector can't be appended to itself, since growing it would free what's being copied, nor to one of a
+    //different stride. Either way `dest` is left as it was.
+    CHECK(cave_vec_append(&dest, &dest, &err) == NULL && err == CAVE_DATA_ERROR);
+    CaveVec narrow;
+    cave_vec_init(&narrow, sizeof(uint32_t), 0, &err);
+    uint32_t one = 1;
+    cave_vec_push(&narrow, &one, &err);
+    CHECK(cave_vec_append(&dest, &narrow, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_append(&narrow, &dest, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK_EQ_U64(dest.len, 2000);
+    CHECK_EQ_U64(narrow.len, 1);
+    CHECK(cave_vec_append(NULL, &src, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_append(&dest, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+
+    cave_vec_release(&narrow);
+    cave_vec_release(&empty);
+    cave_vec_release(&src);
+    cave_vec_release(&dest);
+}
+
+int main(void) {
+    test_push_n();
+    test_append();
+    return test_result("cave-bedrock-ext");
+}
@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include "tests/test.h"
+#include "include/sieve.h"
+#include "include/parallel-sieve.h"
+#include "include/trial-division.h"
+#include "include/miller-rabin.h"
+#include "include/prime-count.h"
+#include "include/direct-filter.h"
+#include "include/growth-filter.h"
+#include "include/pipeline.h"
+
+//Every engine against a plain sieve of Eratosthenes, at the bounds and starting points most likely to be off by
+//one: the tiny bounds below and around the wheel's own primes, a prime + 1, and starts partway into a segment.
+
+#define REFERENCE_LIMIT (300000)
+
+static bool is_composite[REFERENCE_LIMIT];
+
+static void reference_init(void) {
+    is_composite[0] = is_composite[1] = true;
+    for(uint64_t p = 2; p * p < REFERENCE_LIMIT; p++) {
+        if(!is_composite[p]) {
+            for(uint64_t m = p * p; m < REFERENCE_LIMIT; m += p) {
+                is_composite[m] = true;
+            }
+        }
+    }
+}
+
+//the primes in [start, upperbound), from the reference.
+static void reference_primes(CaveVec* primes, uint64_t start, uint64_t upperbound) {
+    CaveError err;
+    cave_vec_init(primes, sizeof(uint64_t), 0, &err);
+    for(uint64_t i = start; i < upperbound; i++) {
+        if(!is_composite[i]) {
+            cave_vec_push(primes, &i, &err);
+        }
+    }
+}
+
+typedef enum Engine {
+    ENGINE_SIEVE,
+    ENGINE_PARALLEL,
+    ENGINE_TRIAL,
+} Engine;
+
+static char const* const ENGINE_NAMES[] = {"sieve", "parallel", "trial"};
+
+static bool engine_primes(CaveVec* primes, Engine engine, uint64_t start, uint64_t upperbound,
+                          size_t segment_bytes, WheelKind wheel, size_t thread_count, CaveError* err) {
+    if(cave_vec_init(primes, sizeof(uint64_t), 0, err) == NULL) {
+        return false;
+    }
+    switch(engine) {
+        case ENGINE_SIEVE:
+            return sieve_foreach_batch_from(start, upperbound, segment_bytes, wheel, prime_batch_push, primes, err);
+        case ENGINE_PARALLEL:
+            return parallel_sieve_foreach_batch_from(start, upperbound, segment_bytes, wheel, thread_count,
+                                                     prime_batch_push, primes, err);
+        case ENGINE_TRIAL:
+            return trial_division_foreach_batch_from(start, upperbound, wheel, prime_batch_push, primes, err);
+    }
+    return false;
+}
+
+static void check_engine(Engine engine, uint64_t start, uint64_t upperbound, size_t segment_bytes, WheelKind wheel,
+                         size_t thread_count) {
+    CaveVec expected;
+    CaveVec actual;
+    CaveError err;
+    reference_primes(&expected, start, upperbound);
+    bool ok = engine_primes(&actual, engine, start, upperbound, segment_bytes, wheel, thread_count, &err);
+    char what[160];
+    snprintf(what, sizeof(what), "%s from %llu below %llu, %zu byte segments, wheel %d, %zu threads",
+             ENGINE_NAMES[engine], (unsigned long long)start, (unsigned long long)upperbound, segment_bytes,
+             (int)wheel, thread_count);
+    if(!ok) {
+        fprintf(stderr, "%s: %s\n", what, cave_error_string(err));
+    }
+    CHECK(ok);
+    CHECK(test_same_u64s(&actual, &expected, what));
+    cave_vec_release(&actual);
+    cave_vec_release(&expected);
+}
+
+static void test_engines_agree(void) {
+    static uint64_t const BOUNDS[] = {2, 3, 4, 8, 11, 12, 100, 7920, 65537, REFERENCE_LIMIT};
+    static WheelKind const WHEELS[] = {WHEEL_30, WHEEL_210};
+    //64 byte segments cover 128 numbers, so every bound above spans several, and 1037 is partway into one.
+    static size_t const SEGMENTS[] = {64, 0};
+    for(size_t w = 0; w < sizeof(WHEELS) / sizeof(WHEELS[0]); w++) {
+        for(size_t b = 0; b < sizeof(BOUNDS) / sizeof(BOUNDS[0]); b++) {
+            uint64_t bound = BOUNDS[b];
+            uint64_t starts[] = {0, 5, 1037, 7919, bound / 2 + 1, bound};
+            for(size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+                if(starts[s] > bound) {
+                    continue;
+                }
+                for(size_t g = 0; g < sizeof(SEGMENTS) / sizeof(SEGMENTS[0]); g++) {
+                    check_engine(ENGINE_SIEVE, starts[s], bound, SEGMENTS[g], WHEELS[w], 0);
+                    check_engine(ENGINE_PARALLEL, starts[s], bound, SEGMENTS[g], WHEELS[w], 1);
+                    check_engine(ENGINE_PARALLEL, starts[s], bound, SEGMENTS[g], WHEELS[w], 3);
+                }
+                check_engine(ENGINE_TRIAL, starts[s], bound, 0, WHEELS[w], 0);
+            }
+        }
+    }
+}
+
+static void test_miller_rabin(void) {
+    for(uint64_t n = 0; n < REFERENCE_LIMIT; n++) {
+        if(miller_rabin_is_prime(n) != !is_composite[n]) {
+            fprintf(stderr, "miller_rabin_is_prime(%llu) is wrong\n", (unsigned long long)n);
+            test_failures++;
+        }
+    }
+    //past the reference: the largest primes below 2^61 and 2^64, and composites that fool smaller sets of bases.
+    CHECK(miller_rabin_is_prime(((uint64_t)1 << 61) - 1));
+    CHECK(miller_rabin_is_prime(UINT64_C(18446744073709551557)));
+    CHECK(!miller_rabin_is_prime(UINT64_C(18446744073709551615)));
+    CHECK(!miller_rabin_is_prime(UINT64_C(3215031751)));
+    CHECK(!miller_rabin_is_prime(UINT64_C(3825123056546413051)));
+    CHECK(!miller_rabin_is_prime(UINT64_C(4294967297)));
+    CHECK_EQ_U64(miller_rabin_next_prime(UINT64_C(18446744073709551534)), UINT64_C(18446744073709551557));
+    CHECK_EQ_U64(miller_rabin_next_prime(7908), 7919);
+}
+
+static void test_prime_count(void) {
+    CaveError err;
+    //every bound the reference covers, a few at a time past the small ones.
+    uint64_t count = 0;
+    for(uint64_t bound = 0; bound < REFERENCE_LIMIT; bound++) {
+        if(bound < 2000 || bound % 997 == 0) {
+            uint64_t counted = prime_count_below(bound, &err);
+            if(counted != count || err != CAVE_NO_ERROR) {
+                fprintf(stderr, "prime_count_below(%llu) is %llu, expected %llu\n", (unsigned long long)bound,
+                        (unsigned long long)counted, (unsigned long long)count);
+                test_failures++;
+            }
+        }
+        count += !is_composite[bound];
+    }
+    //pi(10^k), which none of them are primes, so it's the count below them too.
+    static uint64_t const POWERS_OF_TEN[][2] = {
+            {10, 4}, {100, 25}, {1000, 168}, {10000, 1229}, {1000000, 78498}, {100000000, 5761455},
+            {UINT64_C(10000000000), UINT64_C(455052511)},
+    };
+    for(size_t i = 0; i < sizeof(POWERS_OF_TEN) / sizeof(POWERS_OF_TEN[0]); i++) {
+        CHECK_EQ_U64(prime_count_below(POWERS_OF_TEN[i][0], &err), POWERS_OF_TEN[i][1]);
+        CHECK(err == CAVE_NO_ERROR);
+    }
+}
+
+//the direct filter against every prime streamed through the growth filter, as the other engines are.
+static void test_direct_filter(void) {
+    static uint64_t const BOUNDS[] = {2, 3, 4, 12, 100, 7920, 1000000, 10000000};
+    static double const GROWTHS[] = {1.25, GROWTH_FILTER_DEFAULT_FACTOR, 2};
+    for(size_t b = 0; b < sizeof(BOUNDS) / sizeof(BOUNDS[0]); b++) {
+        for(size_t g = 0; g < sizeof(GROWTHS) / sizeof(GROWTHS[0]); g++) {
+            CaveError err;
+            CaveVec streamed;
+            CaveVec direct;
+            PrimePipeline pipeline;
+            cave_vec_init(&streamed, sizeof(uint64_t), 0, &err);
+            cave_vec_init(&direct, sizeof(uint64_t), 0, &err);
+            CHECK(prime_pipeline_init(&pipeline, &streamed, GROWTHS[g], NULL, NULL, &err) != NULL);
+            CHECK(sieve_foreach_batch(BOUNDS[b], 0, WHEEL_210, prime_pipeline_consume, &pipeline, &err));
+            CHECK(direct_filtered_primes_below(&direct, BOUNDS[b], GROWTHS[g], &err) != NULL);
+            char what[96];
+            snprintf(what, sizeof(what), "direct filter below %llu by %g", (unsigned long long)BOUNDS[b],
+                     GROWTHS[g]);
+            CHECK(test_same_u64s(&direct, &streamed, what));
+            cave_vec_release(&streamed);
+            cave_vec_release(&direct);
+        }
+    }
+}
+
+int main(void) {
+    reference_init();
+    test_engines_agree();
+    test_miller_rabin();
+    test_prime_count();
+    test_direct_filter();
+    return test_result("engines");
+}
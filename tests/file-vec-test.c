@@ -0,0 +1,95 @@
+#include <sys/stat.h>
+#include "tests/test.h"
+#include "include/file-vec.h"
+#include "include/sieve.h"
+
+//A CaveFileVec filled by handing it to a generator as its closure, then read back through
+//the vector and, once released, straight out of the file. The file goes in the working directory, which ctest
+//sets to the build directory.
+
+#define VEC_PATH "file-vec-test.vec"
+
+static void test_consume_and_read_back(void) {
+    CaveError err;
+    CaveFileVec v;
+    CHECK(cave_file_vec_init(&v, VEC_PATH, sizeof(uint64_t), 0, &err) != NULL);
+    //a small segment, so the primes come in many batches and the file grows several times.
+    CHECK(sieve_foreach_batch(1000000, 256, WHEEL_210, cave_file_vec_consume, &v, &err));
+    CHECK(cave_file_vec_sync(&v, &err));
+
+    CaveVec primes;
+    cave_vec_init(&primes, sizeof(uint64_t), 0, &err);
+    sieve_primes_below(&primes, 1000000, 0, WHEEL_210, &err);
+    CHECK(test_same_u64s(cave_file_vec_as_vec(&v), &primes, "file vec of primes"));
+    for(size_t i = 0; i < primes.len; i += 1009) {
+        uint64_t* p = cave_file_vec_at(&v, i, &err);
+        CHECK(p != NULL && *p == ((uint64_t*)primes.data)[i]);
+    }
+    CHECK(cave_file_vec_at(&v, v.vec.len, &err) == NULL && err == CAVE_INDEX_ERROR);
+    size_t len = v.vec.len;
+    CHECK(v.vec.capacity > len);
+    CHECK(cave_file_vec_release(&v, &err));
+
+    //the release leaves exactly the elements in the file, as a plain array.
+    struct stat st;
+    CHECK(stat(VEC_PATH, &st) == 0 && (uint64_t)st.st_size == len * sizeof(uint64_t));
+    FILE* f = fopen(VEC_PATH, "rb");
+    CHECK(f != NULL);
+    if(f != NULL) {
+        CaveVec read;
+        cave_vec_init(&read, sizeof(uint64_t), len, &err);
+        read.len = fread(read.data, sizeof(uint64_t), len, f);
+        CHECK(test_same_u64s(&read, &primes, "file vec's file"));
+        cave_vec_release(&read);
+        fclose(f);
+    }
+    cave_vec_release(&primes);
+    remove(VEC_PATH);
+}
+
+//elements that aren't 8 bytes, pushed one at a time and a few at a time, with an explicit reserve in between.
+static void test_push_and_reserve(void) {
+    CaveError err;
+    CaveFileVec v;
+    CHECK(cave_file_vec_init(&v, VEC_PATH, 3, 1, &err) != NULL);
+    unsigned char element[3] = {1, 2, 3};
+    for(unsigned i = 0; i < 1000; i++) {
+        element[0] = (unsigned char)i;
+        CHECK(cave_file_vec_push(&v, element, &err) != NULL);
+    }
+    CHECK(cave_file_vec_reserve(&v, 100000, &err) != NULL);
+    CHECK_EQ_U64(v.vec.capacity, 100000);
+    unsigned char many[3 * 50];
+    memset(many, 7, sizeof(many));
+    CHECK(cave_file_vec_push_n(&v, many, 50, &err) != NULL);
+    CHECK_EQ_U64(v.vec.len, 1050);
+    unsigned char* at = cave_file_vec_at(&v, 999, &err);
+    CHECK(at != NULL && at[0] == (unsigned char)999 && at[2] == 3);
+    at = cave_file_vec_at(&v, 1049, &err);
+    CHECK(at != NULL && at[0] == 7);
+    //reserving less than there's room for is a no-op.
+    CHECK(cave_file_vec_reserve(&v, 10, &err) != NULL);
+    CHECK_EQ_U64(v.vec.capacity, 100000);
+    CHECK(cave_file_vec_release(&v, &err));
+    remove(VEC_PATH);
+}
+
+static void test_rejects_bad_arguments(void) {
+    CaveError err;
+    CaveFileVec v;
+    CHECK(cave_file_vec_init(&v, VEC_PATH, 0, 0, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_file_vec_init(&v, "no-such-directory/file-vec-test.vec", 8, 0, &err) == NULL);
+    CHECK(err == CAVE_FILE_ERROR);
+    cave_file_vec_init(&v, VEC_PATH, 8, 0, &err);
+    CHECK(cave_file_vec_push(&v, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_file_vec_push_n(&v, NULL, 2, &err) == NULL && err == CAVE_DATA_ERROR);
+    cave_file_vec_release(&v, &err);
+    remove(VEC_PATH);
+}
+
+int main(void) {
+    test_consume_and_read_back();
+    test_push_and_reserve();
+    test_rejects_bad_arguments();
+    return test_result("file-vec");
+}
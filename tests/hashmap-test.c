@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include "tests/test.h"
+#include "include/hashmap.h"
+#include "filtered-primes-table.h"
+
+//cave_fastmod() against %, the map against a plain array of every key, and the two rules for removing that
+//probing depends on: a slot is emptied outright when the next one is empty, and otherwise left as a tombstone,
+//which the map clears out by rehashing at the same capacity once they fill it up.
+
+static uint64_t next_random(uint64_t* x) {
+    *x = *x * 6364136223846793005u + 1442695040888963407u;
+    return *x ^ (*x >> 29);
+}
+
+static void test_fastmod(void) {
+    uint64_t divisors[FILTERED_PRIMES_COUNT + 4];
+    size_t count = 0;
+    for(size_t i = 0; i < FILTERED_PRIMES_COUNT; i++) {
+        if(filtered_primes[i] > 1) {
+            divisors[count++] = filtered_primes[i];
+        }
+    }
+    divisors[count++] = 2;
+    divisors[count++] = 1000000007;
+    divisors[count++] = ((uint64_t)1 << 63) + 1;
+    divisors[count++] = UINT64_MAX;
+
+    uint64_t x = 1;
+    for(size_t d = 0; d < count; d++) {
+        unsigned __int128 m = cave_fastmod_constant(divisors[d]);
+        uint64_t edges[] = {0, 1, divisors[d] - 1, divisors[d], divisors[d] + 1, UINT64_MAX, UINT64_MAX - 1};
+        for(size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+            CHECK_EQ_U64(cave_fastmod(edges[i], m, divisors[d]), edges[i] % divisors[d]);
+        }
+        for(unsigned i = 0; i < 200000; i++) {
+            uint64_t a = next_random(&x);
+            if(cave_fastmod(a, m, divisors[d]) != a % divisors[d]) {
+                fprintf(stderr, "cave_fastmod(%llu) by %llu is wrong\n", (unsigned long long)a,
+                        (unsigned long long)divisors[d]);
+                test_failures++;
+                break;
+            }
+        }
+    }
+}
+
+//the map against an array indexed by key, over a long run of random inserts, removes and gets on a small set
+//of keys, so every key comes and goes many times and the table is full of tombstones throughout.
+#define FUZZ_KEYS (4096)
+
+static void test_against_reference(void) {
+    CaveError err;
+    CaveHashMap m;
+    CHECK(cave_hashmap_init(&m, sizeof(uint64_t), sizeof(uint32_t), 0, NULL, NULL, NULL, &err) != NULL);
+    static bool present[FUZZ_KEYS];
+    static uint32_t values[FUZZ_KEYS];
+    size_t len = 0;
+    uint64_t x = 7;
+    for(unsigned i = 0; i < 1000000; i++) {
+        uint64_t r = next_random(&x);
+        //keys spread out over the whole of 64 bits, so the hash has something to do.
+        uint64_t index = r % FUZZ_KEYS;
+        uint64_t key = index * UINT64_C(0x9e3779b97f4a7c15);
+        switch((r >> 32) % 4) {
+            case 0:
+            case 1: {
+                uint32_t value = (uint32_t)(r >> 40);
+                uint32_t* stored = cave_hashmap_insert(&m, &key, &value, &err);
+                if(stored == NULL || *stored != value) {
+                    fprintf(stderr, "insert of key %llu failed\n", (unsigned long long)index);
+                    test_failures++;
+                }
+                len += !present[index];
+                present[index] = true;
+                values[index] = value;
+                break;
+            }
+            case 2: {
+                bool removed = cave_hashmap_remove(&m, &key, &err);
+                if(removed != present[index] || (!removed && err != CAVE_INDEX_ERROR)) {
+                    fprintf(stderr, "remove of key %llu is wrong\n", (unsigned long long)index);
+                    test_failures++;
+                }
+                len -= present[index];
+                present[index] = false;
+                break;
+            }
+            default: {
+                uint32_t* stored = cave_hashmap_get(&m, &key, &err);
+                bool right = present[index] ? stored != NULL && *stored == values[index]
+                                            : stored == NULL && err == CAVE_INDEX_ERROR;
+                if(!right) {
+                    fprintf(stderr, "get of key %llu is wrong\n", (unsigned long long)index);
+                    test_failures++;
+                }
+                break;
+            }
+        }
+        if(m.len != len) {
+            fprintf(stderr, "after %u operations the map has %zu keys, expected %zu\n", i, m.len, len);
+            test_failures++;
+            break;
+        }
+    }
+    CHECK(filtered_primes[m.capacity_index] == m.capacity);
+    cave_hashmap_release(&m);
+}
+
+//a hash that's just the key, so a test can put keys in the slots it wants.
+static uint64_t identity_hash(void const* key, size_t key_size, void* closure_data) {
+    (void)key_size;
+    (void)closure_data;
+    uint64_t k;
+    memcpy(&k, key, sizeof(k));
+    return k;
+}
+
+static void test_remove_empties_or_tombstones(void) {
+    CaveError err;
+    CaveHashMap m;
+    cave_hashmap_init(&m, sizeof(uint64_t), 0, 0, identity_hash, NULL, NULL, &err);
+    uint64_t c = m.capacity;
+    //a and b both want slot 1, so b goes in slot 2.
+    uint64_t a = 1;
+    uint64_t b = 1 + c;
+    uint64_t d = 1 + 2 * c;
+    cave_hashmap_insert(&m, &a, NULL, &err);
+    cave_hashmap_insert(&m, &b, NULL, &err);
+    CHECK(m.control[1] >= 0x80 && m.control[2] >= 0x80);
+
+    //nothing follows b, so no probe can need to get past its slot, which is just emptied.
+    CHECK(cave_hashmap_remove(&m, &b, &err));
+    CHECK_EQ_U64(m.control[2], 0);
+    CHECK_EQ_U64(m.tombstones, 0);
+
+    //but a probe for b has to get past a's slot, so removing a leaves a tombstone there.
+    cave_hashmap_insert(&m, &b, NULL, &err);
+    CHECK(cave_hashmap_remove(&m, &a, &err));
+    CHECK_EQ_U64(m.control[1], 1);
+    CHECK_EQ_U64(m.tombstones, 1);
+    CHECK(cave_hashmap_get(&m, &b, &err) != NULL);
+    CHECK(cave_hashmap_get(&m, &a, &err) == NULL && err == CAVE_INDEX_ERROR);
+
+    //and the next key that wants that slot gets the tombstone back.
+    CHECK(cave_hashmap_insert(&m, &d, NULL, &err) != NULL);
+    CHECK(m.control[1] >= 0x80);
+    CHECK_EQ_U64(m.tombstones, 0);
+    CHECK_EQ_U64(m.len, 2);
+    cave_hashmap_release(&m);
+}
+
+static void test_rehash_in_place(void) {
+    CaveError err;
+    CaveHashMap m;
+    cave_hashmap_init(&m, sizeof(uint64_t), 0, 0, identity_hash, NULL, NULL, &err);
+    uint64_t c = m.capacity;
+    size_t index = m.capacity_index;
+    //the most slots that may be in use.
+    uint64_t most = c * CAVE_HASHMAP_MAX_LOAD_NUMERATOR / CAVE_HASHMAP_MAX_LOAD_DENOMINATOR;
+    CHECK(most + 1 < c);
+    //a run filling slots 0 to most - 1, all but the last removed from the front, so each leaves a tombstone.
+    for(uint64_t k = 0; k < most; k++) {
+        cave_hashmap_insert(&m, &k, NULL, &err);
+    }
+    CHECK_EQ_U64(m.capacity, c);
+    for(uint64_t k = 0; k + 1 < most; k++) {
+        cave_hashmap_remove(&m, &k, &err);
+    }
+    CHECK_EQ_U64(m.len, 1);
+    CHECK_EQ_U64(m.tombstones, most - 1);
+
+    //one more slot would be too many, but one more key isn't, so it rehashes without growing.
+    uint64_t last = c - 1;
+    CHECK(cave_hashmap_insert(&m, &last, NULL, &err) != NULL);
+    CHECK_EQ_U64(m.capacity, c);
+    CHECK_EQ_U64(m.capacity_index, index);
+    CHECK_EQ_U64(m.tombstones, 0);
+    CHECK_EQ_U64(m.len, 2);
+    uint64_t kept = most - 1;
+    CHECK(cave_hashmap_get(&m, &kept, &err) != NULL);
+    CHECK(cave_hashmap_get(&m, &last, &err) != NULL);
+    for(uint64_t k = 0; k + 1 < most; k++) {
+        CHECK(cave_hashmap_get(&m, &k, &err) == NULL);
+    }
+    cave_hashmap_release(&m);
+}
+
+//growing goes through the filtered primes in order, and keeps every key.
+static void test_growth(void) {
+    CaveError err;
+    CaveHashMap m;
+    cave_hashmap_init(&m, sizeof(uint64_t), sizeof(uint64_t), 1, NULL, NULL, NULL, &err);
+    size_t index = m.capacity_index;
+    for(uint64_t k = 0; k < 100000; k++) {
+        uint64_t v = k * 3;
+        cave_hashmap_insert(&m, &k, &v, &err);
+        CHECK(m.capacity_index == index || m.capacity_index == index + 1);
+        index = m.capacity_index;
+        CHECK(filtered_primes[index] == m.capacity);
+        CHECK(m.len * CAVE_HASHMAP_MAX_LOAD_DENOMINATOR <= m.capacity * CAVE_HASHMAP_MAX_LOAD_NUMERATOR);
+    }
+    for(uint64_t k = 0; k < 100000; k++) {
+        uint64_t* v = cave_hashmap_get(&m, &k, &err);
+        if(v == NULL || *v != k * 3) {
+            fprintf(stderr, "key %llu lost while growing\n", (unsigned long long)k);
+            test_failures++;
+            break;
+        }
+    }
+    cave_hashmap_clear(&m);
+    CHECK_EQ_U64(m.len, 0);
+    CHECK_EQ_U64(m.capacity, filtered_primes[index]);
+    uint64_t k = 5;
+    CHECK(cave_hashmap_get(&m, &k, &err) == NULL && err == CAVE_INDEX_ERROR);
+    cave_hashmap_release(&m);
+}
+
+//keys that aren't 8 bytes, and values that need more alignment than their keys.
+typedef struct OddKey {
+    char bytes[3];
+} OddKey;
+
+static bool equal_ignoring_case(void const* a, void const* b, size_t key_size, void* closure_data) {
+    ++*(unsigned*)closure_data;
+    for(size_t i = 0; i < key_size; i++) {
+        if((((char const*)a)[i] | 0x20) != (((char const*)b)[i] | 0x20)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t hash_ignoring_case(void const* key, size_t key_size, void* closure_data) {
+    OddKey lower;
+    for(size_t i = 0; i < key_size; i++) {
+        lower.bytes[i] = (char)(((char const*)key)[i] | 0x20);
+    }
+    return cave_hash_bytes(&lower, key_size, closure_data);
+}
+
+static void test_odd_sizes_and_closures(void) {
+    CaveError err;
+    CaveHashMap m;
+    unsigned compares = 0;
+    CHECK(cave_hashmap_init(&m, sizeof(OddKey), sizeof(double), 0, hash_ignoring_case, equal_ignoring_case,
+                            &compares, &err) != NULL);
+    CHECK(m.value_offset % _Alignof(double) == 0 && m.entry_size % _Alignof(double) == 0);
+    OddKey upper = {{'A', 'B', 'C'}};
+    OddKey lower = {{'a', 'b', 'c'}};
+    double one = 1;
+    double two = 2;
+    cave_hashmap_insert(&m, &upper, &one, &err);
+    double* stored = cave_hashmap_insert(&m, &lower, &two, &err);
+    CHECK(stored != NULL && *stored == 2 && ((uintptr_t)stored % _Alignof(double)) == 0);
+    CHECK_EQ_U64(m.len, 1);
+    CHECK(compares > 0);
+    cave_hashmap_release(&m);
+
+    //a set: no values, and what's handed back is the key.
+    cave_hashmap_init(&m, sizeof(OddKey), 0, 0, NULL, NULL, NULL, &err);
+    OddKey* key = cave_hashmap_insert(&m, &upper, NULL, &err);
+    CHECK(key != NULL && memcmp(key, &upper, sizeof(OddKey)) == 0);
+    CHECK(cave_hashmap_get(&m, &lower, &err) == NULL);
+    cave_hashmap_release(&m);
+}
+
+static void test_rejects_bad_arguments(void) {
+    CaveError err;
+    CaveHashMap m;
+    CHECK(cave_hashmap_init(&m, 0, 8, 0, NULL, NULL, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_hashmap_init(NULL, 8, 8, 0, NULL, NULL, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    cave_hashmap_init(&m, sizeof(uint64_t), sizeof(uint64_t), 0, NULL, NULL, NULL, &err);
+    uint64_t k = 1;
+    CHECK(cave_hashmap_insert(&m, &k, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_hashmap_insert(&m, NULL, &k, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(!cave_hashmap_remove(&m, &k, &err) && err == CAVE_INDEX_ERROR);
+    cave_hashmap_release(&m);
+}
+
+int main(void) {
+    test_fastmod();
+    test_against_reference();
+    test_remove_empties_or_tombstones();
+    test_rehash_in_place();
+    test_growth();
+    test_odd_sizes_and_closures();
+    test_rejects_bad_arguments();
+    return test_result("hashmap");
+}
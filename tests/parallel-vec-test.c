@@ -0,0 +1,159 @@
+#include "tests/test.h"
+#include "include/parallel-vec.h"
+
+//The parallel passes against the serial ones, over vectors long enough to be cut into up to 9 ranges, and what's
+//left when a closure fails partway.
+
+#define TEST_LEN (9 * PARALLEL_VEC_MIN_RANGE + 123)
+
+static void fill(CaveVec* v, size_t len) {
+    CaveError err;
+    cave_vec_init(v, sizeof(uint64_t), len, &err);
+    for(uint64_t i = 0; i < len; i++) {
+        cave_vec_push(v, &i, &err);
+    }
+}
+
+//keeps an element when its hash is below closure_data's threshold, out of 1024, so any density can be asked for.
+static bool keep_below(void const* element, void* closure_data, CaveError* err) {
+    (void)err;
+    uint64_t x = *(uint64_t const*)element * UINT64_C(0x9e3779b97f4a7c15);
+    return (x >> 54) < *(uint64_t const*)closure_data;
+}
+
+//keeps everything from closure_data on, so the first range keeps nothing and every range after keeps all of
+//its elements. Each range's destination is then where the range before it still is, so the moves happen in
+//a chain of rounds, one per range.
+static bool keep_from(void const* element, void* closure_data, CaveError* err) {
+    (void)err;
+    return *(uint64_t const*)element >= *(uint64_t const*)closure_data;
+}
+
+static void check_filter(CAVE_FILTER_CLOSURE fn, uint64_t threshold, size_t thread_count) {
+    CaveError err;
+    CaveVec parallel;
+    CaveVec serial;
+    fill(&parallel, TEST_LEN);
+    fill(&serial, TEST_LEN);
+    CHECK(cave_vec_parallel_filter(&parallel, thread_count, fn, &threshold, &err) != NULL);
+    CHECK(cave_vec_filter(&serial, fn, &threshold, &err) != NULL);
+    char what[96];
+    snprintf(what, sizeof(what), "filter with threshold %llu on %zu threads", (unsigned long long)threshold,
+             thread_count);
+    CHECK(test_same_u64s(&parallel, &serial, what));
+    cave_vec_release(&parallel);
+    cave_vec_release(&serial);
+}
+
+static void test_filter(void) {
+    static uint64_t const DENSITIES[] = {0, 1, 100, 512, 1000, 1023, 1024};
+    for(size_t t = 1; t <= 9; t++) {
+        for(size_t d = 0; d < sizeof(DENSITIES) / sizeof(DENSITIES[0]); d++) {
+            check_filter(keep_below, DENSITIES[d], t);
+        }
+        check_filter(keep_from, TEST_LEN / t, t);
+        check_filter(keep_from, TEST_LEN / 9, t);
+        check_filter(keep_from, 1, t);
+    }
+}
+
+static void add_one(void* element, void* closure_data, CaveError* err) {
+    (void)closure_data;
+    (void)err;
+    *(uint64_t*)element += 1;
+}
+
+static void halve(void const* input, void* output, void* closure_data, CaveError* err) {
+    (void)closure_data;
+    (void)err;
+    *(uint32_t*)output = (uint32_t)(*(uint64_t const*)input / 2);
+}
+
+static void test_foreach_and_map(void) {
+    for(size_t t = 1; t <= 9; t += 4) {
+        CaveError err;
+        CaveVec v;
+        CaveVec mapped;
+        fill(&v, TEST_LEN);
+        CHECK(cave_vec_parallel_foreach(&v, t, add_one, NULL, &err) != NULL);
+        CHECK(cave_vec_parallel_map(&mapped, &v, sizeof(uint32_t), t, halve, NULL, &err) != NULL);
+        CHECK_EQ_U64(mapped.len, TEST_LEN);
+        for(size_t i = 0; i < TEST_LEN; i++) {
+            if(((uint64_t*)v.data)[i] != i + 1 || ((uint32_t*)mapped.data)[i] != (i + 1) / 2) {
+                fprintf(stderr, "foreach or map on %zu threads is wrong at %zu\n", t, i);
+                test_failures++;
+                break;
+            }
+        }
+        cave_vec_release(&v);
+        cave_vec_release(&mapped);
+    }
+}
+
+//each of these fails at the element equal to closure_data, partway into one of the later ranges.
+
+static bool keep_or_fail(void const* element, void* closure_data, CaveError* err) {
+    if(*(uint64_t const*)element == *(uint64_t const*)closure_data) {
+        *err = CAVE_INDEX_ERROR;
+    }
+    return *(uint64_t const*)element % 3 != 0;
+}
+
+static void add_one_or_fail(void* element, void* closure_data, CaveError* err) {
+    if(*(uint64_t*)element == *(uint64_t const*)closure_data) {
+        *err = CAVE_INDEX_ERROR;
+    }
+    *(uint64_t*)element += 1;
+}
+
+static void halve_or_fail(void const* input, void* output, void* closure_data, CaveError* err) {
+    if(*(uint64_t const*)input == *(uint64_t const*)closure_data) {
+        *err = CAVE_INDEX_ERROR;
+    }
+    *(uint32_t*)output = (uint32_t)(*(uint64_t const*)input / 2);
+}
+
+static void test_failing_closure(void) {
+    uint64_t fail_at = TEST_LEN / 2 + 17;
+    for(size_t t = 1; t <= 9; t += 2) {
+        CaveError err;
+        CaveVec v;
+        fill(&v, TEST_LEN);
+        CHECK(cave_vec_parallel_filter(&v, t, keep_or_fail, &fail_at, &err) == NULL);
+        CHECK(err == CAVE_INDEX_ERROR);
+        //the header promises the length is left alone, even if elements have been moved about.
+        CHECK_EQ_U64(v.len, TEST_LEN);
+        cave_vec_release(&v);
+
+        fill(&v, TEST_LEN);
+        CHECK(cave_vec_parallel_foreach(&v, t, add_one_or_fail, &fail_at, &err) == NULL);
+        CHECK(err == CAVE_INDEX_ERROR);
+        CHECK_EQ_U64(v.len, TEST_LEN);
+        cave_vec_release(&v);
+
+        CaveVec mapped;
+        fill(&v, TEST_LEN);
+        CHECK(cave_vec_parallel_map(&mapped, &v, sizeof(uint32_t), t, halve_or_fail, &fail_at, &err) == NULL);
+        CHECK(err == CAVE_INDEX_ERROR);
+        cave_vec_release(&v);
+    }
+}
+
+static void test_rejects_bad_arguments(void) {
+    CaveError err;
+    CaveVec v;
+    CaveVec mapped;
+    fill(&v, 10);
+    CHECK(cave_vec_parallel_filter(NULL, 2, keep_from, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_parallel_foreach(&v, 2, NULL, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    CHECK(cave_vec_parallel_map(&mapped, &v, 0, 2, halve, NULL, &err) == NULL && err == CAVE_DATA_ERROR);
+    cave_vec_release(&v);
+}
+
+int main(void) {
+    test_filter();
+    test_foreach_and_map();
+    test_failing_closure();
+    test_rejects_bad_arguments();
+    return test_result("parallel-vec");
+}
@@ -0,0 +1,119 @@
+#include "tests/test.h"
+#include "include/prime-store.h"
+#include "include/sieve.h"
+
+//The store against the plain list it's standing in for: every prime below a bound, plus made up values with the
+//gaps a byte can't hold, read back by walking it, by iterating from partway in, and by index.
+
+static void check_round_trip(CaveVec const* values, char const* what) {
+    CaveError err;
+    PrimeStore store;
+    CHECK(prime_store_init(&store, &err) != NULL);
+    CHECK(prime_store_push_n(&store, values->data, values->len, &err) != NULL);
+    CHECK_EQ_U64(store.len, values->len);
+
+    uint64_t const* expected = values->data;
+    PrimeStoreIter it;
+    uint64_t prime;
+    size_t walked = 0;
+    prime_store_iter_init(&it, &store, 0);
+    while(prime_store_iter_next(&it, &prime)) {
+        if(walked >= values->len || prime != expected[walked]) {
+            fprintf(stderr, "%s: walking, index %zu is wrong\n", what, walked);
+            test_failures++;
+            break;
+        }
+        walked++;
+    }
+    CHECK_EQ_U64(walked, values->len);
+
+    //every index near a block boundary, and a spread of the rest.
+    for(size_t i = 0; i < values->len; i++) {
+        size_t in_block = i % PRIME_STORE_BLOCK_SIZE;
+        if(in_block > 1 && in_block < PRIME_STORE_BLOCK_SIZE - 1 && i % 97 != 0) {
+            continue;
+        }
+        if(prime_store_at(&store, i, &err) != expected[i] || err != CAVE_NO_ERROR) {
+            fprintf(stderr, "%s: prime_store_at(%zu) is wrong\n", what, i);
+            test_failures++;
+        }
+        //an iterator started here should pick up the walk from the same place.
+        if(i % 389 == 0) {
+            prime_store_iter_init(&it, &store, i);
+            for(size_t j = i; j < values->len && j < i + 2 * PRIME_STORE_BLOCK_SIZE; j++) {
+                if(!prime_store_iter_next(&it, &prime) || prime != expected[j]) {
+                    fprintf(stderr, "%s: iterating from %zu, index %zu is wrong\n", what, i, j);
+                    test_failures++;
+                    break;
+                }
+            }
+        }
+    }
+    prime_store_at(&store, values->len, &err);
+    CHECK(err == CAVE_INDEX_ERROR);
+    prime_store_iter_init(&it, &store, values->len);
+    CHECK(!prime_store_iter_next(&it, &prime));
+    prime_store_release(&store);
+}
+
+static void test_primes(void) {
+    CaveError err;
+    CaveVec primes;
+    cave_vec_init(&primes, sizeof(uint64_t), 0, &err);
+    CHECK(sieve_primes_below(&primes, 2000000, 0, WHEEL_210, &err) != NULL);
+    check_round_trip(&primes, "primes below 2000000");
+    cave_vec_release(&primes);
+}
+
+//gaps of every size a varint takes 1 to 10 bytes for, odd ones among them, and repeats.
+static void test_big_gaps(void) {
+    CaveError err;
+    CaveVec values;
+    cave_vec_init(&values, sizeof(uint64_t), 0, &err);
+    uint64_t value = 0;
+    for(unsigned i = 0; i < 3000; i++) {
+        uint64_t gap;
+        switch(i % 5) {
+            case 0:
+                gap = (uint64_t)1 << (i / 5 % 63);
+                break;
+            case 1:
+                gap = 1;
+                break;
+            case 2:
+                gap = 0;
+                break;
+            default:
+                gap = 2 * (i % 300);
+                break;
+        }
+        if(value > UINT64_MAX - gap) {
+            break;
+        }
+        value += gap;
+        cave_vec_push(&values, &value, &err);
+    }
+    check_round_trip(&values, "big gaps");
+    cave_vec_release(&values);
+}
+
+static void test_rejects_descending(void) {
+    CaveError err;
+    PrimeStore store;
+    prime_store_init(&store, &err);
+    uint64_t values[] = {5, 7, 3};
+    CHECK(prime_store_push_n(&store, values, 3, &err) == NULL);
+    CHECK(err == CAVE_DATA_ERROR);
+    //the values before the one out of order are still appended.
+    CHECK_EQ_U64(store.len, 2);
+    CHECK_EQ_U64(prime_store_at(&store, 1, &err), 7);
+    CHECK(prime_store_push(&store, 6, &err) == NULL);
+    prime_store_release(&store);
+}
+
+int main(void) {
+    test_primes();
+    test_big_gaps();
+    test_rejects_descending();
+    return test_result("prime-store");
+}
@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "tests/test.h"
+#include "include/prime-table.h"
+#include "include/sieve.h"
+#include "include/miller-rabin.h"
+
+//Tables written with the writer, the way --format binary and --all-primes write them, then mapped back with
+//prime_table_open(), and files that have been cut short or scribbled on, which have to be turned away. The files
+//go in the working directory, which ctest sets to the build directory.
+
+#define TABLE_PATH "prime-table-test.bin"
+
+static bool file_exists(char const* path) {
+    return access(path, F_OK) == 0;
+}
+
+static void check_table(char const* path, CaveVec const* values, uint64_t bound, double growth, uint32_t width) {
+    CaveError err;
+    PrimeTable t;
+    CHECK(prime_table_open(&t, path, true, &err) != NULL);
+    if(err != CAVE_NO_ERROR) {
+        return;
+    }
+    CHECK_EQ_U64(t.header.version, PRIME_TABLE_VERSION);
+    CHECK_EQ_U64(t.header.element_width, width);
+    CHECK_EQ_U64(t.header.bound, bound);
+    CHECK_EQ_U64(t.header.count, values->len);
+    CHECK(t.header.growth == growth);
+    uint64_t const* expected = values->data;
+    for(size_t i = 0; i < values->len; i++) {
+        if(prime_table_at(&t, i) != expected[i]) {
+            fprintf(stderr, "%s: index %zu is %llu, expected %llu\n", path, i,
+                    (unsigned long long)prime_table_at(&t, i), (unsigned long long)expected[i]);
+            test_failures++;
+            break;
+        }
+    }
+    prime_table_close(&t);
+}
+
+//every prime below a bound, streamed into the writer a batch at a time, as --all-primes does.
+static void test_streamed_round_trip(void) {
+    CaveError err;
+    uint64_t bound = 1000000;
+    PrimeTableWriter w;
+    CHECK(prime_table_writer_open(&w, TABLE_PATH, bound, 0, prime_table_width_for(bound), &err) != NULL);
+    CHECK(sieve_foreach_batch(bound, 0, WHEEL_210, prime_table_writer_consume, &w, &err));
+    //nothing is at the path until the table is complete.
+    CHECK(!file_exists(TABLE_PATH));
+    CHECK(prime_table_writer_close(&w, &err));
+    CHECK(!file_exists(TABLE_PATH ".tmp"));
+
+    CaveVec primes;
+    cave_vec_init(&primes, sizeof(uint64_t), 0, &err);
+    sieve_primes_below(&primes, bound, 0, WHEEL_210, &err);
+    check_table(TABLE_PATH, &primes, bound, 0, 4);
+    cave_vec_release(&primes);
+    remove(TABLE_PATH);
+}
+
+//values past 2^32, which need the 8 byte width.
+static void test_wide_round_trip(void) {
+    CaveError err;
+    uint64_t bound = (uint64_t)1 << 40;
+    CaveVec values;
+    cave_vec_init(&values, sizeof(uint64_t), 0, &err);
+    for(uint64_t p = 2; p < bound; p = miller_rabin_next_prime(p + p / 2 + 1)) {
+        cave_vec_push(&values, &p, &err);
+    }
+    CHECK_EQ_U64(prime_table_width_for(bound), 8);
+    CHECK(prime_table_write(TABLE_PATH, &values, bound, 1.5, &err));
+    check_table(TABLE_PATH, &values, bound, 1.5, 8);
+    cave_vec_release(&values);
+    remove(TABLE_PATH);
+}
+
+//overwrites `size` bytes at `offset` of the file at `path`.
+static void scribble(char const* path, long offset, void const* bytes, size_t size) {
+    FILE* f = fopen(path, "r+b");
+    CHECK(f != NULL);
+    if(f != NULL) {
+        CHECK(fseek(f, offset, SEEK_SET) == 0 && fwrite(bytes, 1, size, f) == size);
+        fclose(f);
+    }
+}
+
+static CaveError open_error(char const* path, bool verify) {
+    CaveError err;
+    PrimeTable t;
+    if(prime_table_open(&t, path, verify, &err) != NULL) {
+        prime_table_close(&t);
+    }
+    return err;
+}
+
+static void write_small_table(void) {
+    CaveError err;
+    CaveVec primes;
+    cave_vec_init(&primes, sizeof(uint64_t), 0, &err);
+    sieve_primes_below(&primes, 10000, 0, WHEEL_210, &err);
+    CHECK(prime_table_write(TABLE_PATH, &primes, 10000, 0, &err));
+    cave_vec_release(&primes);
+}
+
+static void test_rejects_damaged(void) {
+    unsigned char byte = 0xff;
+
+    //a value changed after the checksum was taken is only caught when verifying.
+    write_small_table();
+    scribble(TABLE_PATH, PRIME_TABLE_HEADER_BYTES + 100, &byte, 1);
+    CHECK(open_error(TABLE_PATH, true) == CAVE_DATA_ERROR);
+    CHECK(open_error(TABLE_PATH, false) == CAVE_NO_ERROR);
+
+    //so is a changed checksum.
+    write_small_table();
+    scribble(TABLE_PATH, 40, &byte, 1);
+    CHECK(open_error(TABLE_PATH, true) == CAVE_DATA_ERROR);
+
+    //a file cut short doesn't match its header's count, which is caught either way.
+    write_small_table();
+    CHECK(truncate(TABLE_PATH, PRIME_TABLE_HEADER_BYTES + 100) == 0);
+    CHECK(open_error(TABLE_PATH, false) == CAVE_DATA_ERROR);
+    CHECK(truncate(TABLE_PATH, 10) == 0);
+    CHECK(open_error(TABLE_PATH, false) == CAVE_DATA_ERROR);
+
+    //as is anything that isn't a table at all, or a version from the future.
+    write_small_table();
+    scribble(TABLE_PATH, 0, "NOTABLE", 8);
+    CHECK(open_error(TABLE_PATH, false) == CAVE_DATA_ERROR);
+    write_small_table();
+    unsigned char version[4] = {PRIME_TABLE_VERSION + 1, 0, 0, 0};
+    scribble(TABLE_PATH, 8, version, sizeof(version));
+    CHECK(open_error(TABLE_PATH, false) == CAVE_DATA_ERROR);
+
+    remove(TABLE_PATH);
+    CHECK(open_error(TABLE_PATH, false) == CAVE_FILE_ERROR);
+}
+
+static void test_writer_rejects_bad_values(void) {
+    CaveError err;
+    PrimeTableWriter w;
+    uint64_t descending[] = {3, 5, 4};
+    CHECK(prime_table_writer_open(&w, TABLE_PATH, 100, 0, 4, &err) != NULL);
+    CHECK(prime_table_writer_write(&w, descending, 3, &err) == NULL);
+    CHECK(err == CAVE_DATA_ERROR);
+    prime_table_writer_abandon(&w);
+    CHECK(!file_exists(TABLE_PATH) && !file_exists(TABLE_PATH ".tmp"));
+
+    uint64_t too_big[] = {101};
+    CHECK(prime_table_writer_open(&w, TABLE_PATH, 100, 0, 4, &err) != NULL);
+    CHECK(prime_table_writer_write(&w, too_big, 1, &err) == NULL);
+    CHECK(err == CAVE_DATA_ERROR);
+    prime_table_writer_abandon(&w);
+
+    CHECK(prime_table_writer_open(&w, TABLE_PATH, 100, 0, 3, &err) == NULL);
+    CHECK(err == CAVE_DATA_ERROR);
+}
+
+int main(void) {
+    test_streamed_round_trip();
+    test_wide_round_trip();
+    test_rejects_damaged();
+    test_writer_rejects_bad_values();
+    return test_result("prime-table");
+}
@@ -0,0 +1,63 @@
+#ifndef FILTERED_PRIMES_TEST_H
+#define FILTERED_PRIMES_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "include/cave-bedrock.h"
+
+//The little each test executable shares. A CHECK that fails prints where and what, and the test carries on, so one
+//run shows every failure. main() returns test_result(), which ctest reads as pass or fail.
+
+static unsigned test_failures = 0;
+
+#define CHECK(cond)                                                                                                \
+    do {                                                                                                           \
+        if(!(cond)) {                                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                               \
+            test_failures++;                                                                                       \
+        }                                                                                                          \
+    } while(0)
+
+//the same, with the values that were compared, which is most of what's wanted when one of these fails.
+#define CHECK_EQ_U64(actual, expected)                                                                             \
+    do {                                                                                                           \
+        uint64_t check_actual = (actual);                                                                          \
+        uint64_t check_expected = (expected);                                                                      \
+        if(check_actual != check_expected) {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%llu != %llu)\n", __FILE__, __LINE__, #actual,         \
+                    #expected, (unsigned long long)check_actual, (unsigned long long)check_expected);              \
+            test_failures++;                                                                                       \
+        }                                                                                                          \
+    } while(0)
+
+static inline int test_result(char const* name) {
+    if(test_failures > 0) {
+        fprintf(stderr, "%s: %u check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+//whether two vectors of uint64_t hold the same values, printing the first difference if they don't.
+static inline bool test_same_u64s(CaveVec const* actual, CaveVec const* expected, char const* what) {
+    uint64_t const* a = actual->data;
+    uint64_t const* e = expected->data;
+    size_t n = actual->len < expected->len ? actual->len : expected->len;
+    for(size_t i = 0; i < n; i++) {
+        if(a[i] != e[i]) {
+            fprintf(stderr, "%s: index %zu is %llu, expected %llu\n", what, i, (unsigned long long)a[i],
+                    (unsigned long long)e[i]);
+            return false;
+        }
+    }
+    if(actual->len != expected->len) {
+        fprintf(stderr, "%s: %zu values, expected %zu\n", what, actual->len, expected->len);
+        return false;
+    }
+    return true;
+}
+
+#endif //FILTERED_PRIMES_TEST_H